@@ -14,13 +14,6 @@ pkg_check_modules(GST_APP REQUIRED IMPORTED_TARGET gstreamer-app-1.0>=1.26)
 
 include(FetchContent)
 
-FetchContent_Declare(
-  readerwriterqueue
-  GIT_REPOSITORY https://github.com/cameron314/readerwriterqueue
-  GIT_TAG master # Using released version may trigger CMake deprecation warning (< 3.10)
-)
-FetchContent_MakeAvailable(readerwriterqueue)
-
 FetchContent_Declare(
   fmt
   GIT_REPOSITORY https://github.com/fmtlib/fmt
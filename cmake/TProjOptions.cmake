@@ -27,4 +27,8 @@ option(GEN_TAU_CMAKE_VERBOSE "Enable Gen-τ CMake verbose output" OFF)
 
 # ========================= GEN_TAU GLOBAL TEST OPTIONS ==========================
 option(GEN_TAU_BUILD_TESTS "Build Gen-τ tests" OFF)
-# ========================= GEN_TAU GLOBAL TEST OPTIONS ==========================
\ No newline at end of file
+# ========================= GEN_TAU GLOBAL TEST OPTIONS ==========================
+
+# ========================= GEN_TAU GLOBAL TOOL OPTIONS ==========================
+option(GEN_TAU_BUILD_TOOLS "Build Gen-τ developer tools" OFF)
+# ========================= GEN_TAU GLOBAL TOOL OPTIONS ==========================
\ No newline at end of file
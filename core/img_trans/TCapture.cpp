@@ -0,0 +1,153 @@
+#include "img_trans/net/TCapture.hpp"
+
+#include "utils/TLog.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include <algorithm>
+#include <system_error>
+
+#define T_LOG_TAG_IMG "[Capture] "
+
+using namespace std;
+
+namespace gentau {
+TCaptureRecorder::TCaptureRecorder(const std::string& path)
+{
+	fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		lastErr = errno;
+		tImgTransLogError(
+			"Failed to create capture file '{}', error: {}",
+			path,
+			error_code(lastErr, system_category()).message()
+		);
+		return;
+	}
+
+	if (auto err = reserve(sizeof(TCaptureFormat::FileHeader)); err != 0) {
+		lastErr = err;
+		tImgTransLogError(
+			"Failed to allocate capture file '{}', error: {}",
+			path,
+			error_code(err, system_category()).message()
+		);
+		return;
+	}
+
+	TCaptureFormat::FileHeader header{};
+	memcpy(header.magic, TCaptureFormat::magic, sizeof(header.magic));
+	header.version = TCaptureFormat::version;
+
+	memcpy(mapped, &header, sizeof(header));
+	cursor = sizeof(header);
+
+	tImgTransLogInfo("Capturing datagrams to '{}'", path);
+}
+
+i32 TCaptureRecorder::reserve(u64 len) noexcept
+{
+	if (cursor + len <= capacity) { return 0; }
+
+	auto newCapacity = capacity + max(growStep, TCaptureFormat::paddedLen(len));
+
+	// Allocate the blocks now, a write to a hole of the mapping on a full disk raises SIGBUS
+	if (auto err = ::posix_fallocate(fd, static_cast<off_t>(capacity), newCapacity - capacity);
+		err != 0) {
+		return err;
+	}
+
+	void* addr = MAP_FAILED;
+#ifdef __linux__
+	if (mapped) {
+		addr = ::mremap(mapped, capacity, newCapacity, MREMAP_MAYMOVE);
+	} else {
+		addr = ::mmap(nullptr, newCapacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+#else
+	if (mapped) { ::munmap(mapped, capacity); }
+	mapped = nullptr;
+	addr   = ::mmap(nullptr, newCapacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+#endif
+
+	if (addr == MAP_FAILED) { return errno; }
+
+	mapped   = static_cast<u8*>(addr);
+	capacity = newCapacity;
+
+	return 0;
+}
+
+i32 TCaptureRecorder::append(
+	std::span<const u8>       head,
+	std::span<const u8>       payload,
+	TVidRender::WallTimePoint rxTime,
+	TimePoint                 arrival
+) noexcept
+{
+	if (!isOpen()) { return lastErr != 0 ? lastErr : EBADF; }
+
+	auto len    = head.size() + payload.size();
+	auto needed = sizeof(TCaptureFormat::RecordHeader) + TCaptureFormat::paddedLen(len);
+
+	if (auto err = reserve(needed); err != 0) {
+		lastErr = err;
+		tImgTransLogError(
+			"Capture stopped after {} records, error: {}",
+			records,
+			error_code(err, system_category()).message()
+		);
+		return err;
+	}
+
+	if (records == 0) { firstArrival = arrival; }
+
+	auto sinceFirst = max(arrival - firstArrival, TimePoint::duration::zero());
+
+	TCaptureFormat::RecordHeader record{};
+	record.arrivalNs = static_cast<u64>(chrono::nanoseconds(sinceFirst).count());
+	record.rxTimeNs  = chrono::nanoseconds(rxTime.time_since_epoch()).count();
+	record.len       = static_cast<u32>(len);
+
+	u8* dest = mapped + cursor;
+	memcpy(dest, &record, sizeof(record));
+	dest += sizeof(record);
+
+	if (!head.empty()) { memcpy(dest, head.data(), head.size()); }
+	if (!payload.empty()) { memcpy(dest + head.size(), payload.data(), payload.size()); }
+
+	// The padding of a preallocated region already reads as zero
+
+	cursor += needed;
+	records++;
+
+	return 0;
+}
+
+i32 TCaptureRecorder::close() noexcept
+{
+	i32 err = 0;
+
+	if (mapped) {
+		if (::munmap(mapped, capacity) < 0) { err = errno; }
+		mapped = nullptr;
+	}
+
+	if (fd > -1) {
+		// Drop the preallocated tail, so the file ends right after the last record
+		if (::ftruncate(fd, static_cast<off_t>(cursor)) < 0 && err == 0) { err = errno; }
+		::close(fd);
+		fd = -1;
+
+		tImgTransLogInfo("Capture closed, {} records, {} bytes", records, cursor);
+	}
+
+	capacity = 0;
+	return err;
+}
+}  // namespace gentau
@@ -0,0 +1,171 @@
+#include "img_trans/net/TImpairment.hpp"
+
+#include "utils/TLog.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#define T_LOG_TAG_IMG "[Impairment] "
+
+using namespace std;
+
+namespace gentau {
+namespace {
+template<typename HeldT>
+bool releasesLater(const HeldT& a, const HeldT& b) noexcept
+{
+	if (a.releaseAt != b.releaseAt) { return a.releaseAt > b.releaseAt; }
+	return a.seq > b.seq;
+}
+}  // namespace
+
+TImpairment::TImpairment(const Options& _options, u32 maxPacketLen) :
+	options(_options),
+	slotLen(maxPacketLen),
+	rngState(_options.seed)
+{
+	pool.resize(static_cast<size_t>(options.maxHeld) * slotLen);
+	freeSlots.reserve(options.maxHeld);
+	heap.reserve(options.maxHeld);
+
+	for (u32 i = options.maxHeld; i > 0; i--) { freeSlots.push_back(i - 1); }
+
+	tImgTransLogInfo(
+		"Impairment enabled (seed {}): loss {:.4f}, burst enter/exit/loss {:.4f}/{:.4f}/{:.4f}, "
+		"duplicate {:.4f}, reorder {:.4f} (+{} us), delay {} us + jitter {} us",
+		options.seed,
+		options.lossRate,
+		options.burstEnter,
+		options.burstExit,
+		options.burstLossRate,
+		options.duplicateRate,
+		options.reorderRate,
+		options.reorderDelay.count(),
+		options.delay.count(),
+		options.jitter.count()
+	);
+}
+
+f64 TImpairment::nextUniform() noexcept
+{
+	// splitmix64, fully specified unlike the std distributions, so sweeps replay everywhere
+	u64 z = (rngState += 0x9e37'79b9'7f4a'7c15);
+	z     = (z ^ (z >> 30)) * 0xbf58'476d'1ce4'e5b9;
+	z     = (z ^ (z >> 27)) * 0x94d0'49bb'1331'11eb;
+	z     = z ^ (z >> 31);
+
+	return static_cast<f64>(z >> 11) * 0x1.0p-53;
+}
+
+auto TImpairment::drawDelay() noexcept -> TimePoint::duration
+{
+	auto held = chrono::duration_cast<TimePoint::duration>(options.delay);
+
+	if (options.jitter > Options::Duration::zero()) {
+		auto jitter = chrono::duration_cast<TimePoint::duration>(options.jitter);
+		held += chrono::duration_cast<TimePoint::duration>(jitter * nextUniform());
+	}
+
+	return held;
+}
+
+bool TImpairment::hold(std::span<const u8> packet, TVidRender::WallTimePoint rxTime, TimePoint at)
+{
+	if (freeSlots.empty() || packet.size() > slotLen) { return false; }
+
+	auto slot = freeSlots.back();
+	freeSlots.pop_back();
+
+	memcpy(slotData(slot), packet.data(), packet.size());
+
+	heap.push_back(Held{ at, seq++, slot, static_cast<u32>(packet.size()), rxTime });
+	push_heap(heap.begin(), heap.end(), releasesLater<Held>);
+
+	return true;
+}
+
+auto TImpairment::submit(
+	std::span<const u8> packet, TVidRender::WallTimePoint rxTime, TimePoint now
+) -> Verdict
+{
+	submitted.fetch_add(1, memory_order_relaxed);
+
+	if (options.burstEnter > 0.0) {
+		// Move the channel state first, then lose the datagram according to the new state
+		if (inBurst) {
+			if (nextUniform() < options.burstExit) { inBurst = false; }
+		} else if (nextUniform() < options.burstEnter) {
+			inBurst = true;
+		}
+
+		if (inBurst && nextUniform() < options.burstLossRate) {
+			lost.fetch_add(1, memory_order_relaxed);
+			burstLost.fetch_add(1, memory_order_relaxed);
+			return Verdict::DROP;
+		}
+	}
+
+	if (options.lossRate > 0.0 && nextUniform() < options.lossRate) {
+		lost.fetch_add(1, memory_order_relaxed);
+		return Verdict::DROP;
+	}
+
+	bool duplicate = options.duplicateRate > 0.0 && nextUniform() < options.duplicateRate;
+	bool reorder   = options.reorderRate > 0.0 && nextUniform() < options.reorderRate;
+
+	auto held = drawDelay();
+	if (reorder) { held += chrono::duration_cast<TimePoint::duration>(options.reorderDelay); }
+
+	auto verdict = Verdict::PASS;
+
+	if (held > TimePoint::duration::zero()) {
+		if (hold(packet, rxTime, now + held)) {
+			verdict = Verdict::HELD;
+			(reorder ? reordered : delayed).fetch_add(1, memory_order_relaxed);
+		} else {
+			overflowed.fetch_add(1, memory_order_relaxed);
+		}
+	}
+
+	if (duplicate) {
+		// A zero delay still releases the copy after the original, on the next popDue()
+		if (hold(packet, rxTime, now + drawDelay())) {
+			duplicated.fetch_add(1, memory_order_relaxed);
+		} else {
+			overflowed.fetch_add(1, memory_order_relaxed);
+		}
+	}
+
+	return verdict;
+}
+
+bool TImpairment::popDue(TimePoint now, TPacket& out)
+{
+	if (releasedSlot != UINT32_MAX) {
+		freeSlots.push_back(releasedSlot);
+		releasedSlot = UINT32_MAX;
+	}
+
+	if (heap.empty() || heap.front().releaseAt > now) { return false; }
+
+	pop_heap(heap.begin(), heap.end(), releasesLater<Held>);
+	auto held = heap.back();
+	heap.pop_back();
+
+	releasedSlot = held.slot;
+	out          = TPacket{ std::span(slotData(held.slot), held.len), held.rxTime };
+
+	return true;
+}
+
+auto TImpairment::getStats() const noexcept -> Stats
+{
+	return Stats{ .submitted  = submitted.load(memory_order_relaxed),
+				  .lost       = lost.load(memory_order_relaxed),
+				  .burstLost  = burstLost.load(memory_order_relaxed),
+				  .duplicated = duplicated.load(memory_order_relaxed),
+				  .reordered  = reordered.load(memory_order_relaxed),
+				  .delayed    = delayed.load(memory_order_relaxed),
+				  .overflowed = overflowed.load(memory_order_relaxed) };
+}
+}  // namespace gentau
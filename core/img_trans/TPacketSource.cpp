@@ -0,0 +1,474 @@
+#include "img_trans/net/TPacketSource.hpp"
+
+#include "img_trans/net/TImpairment.hpp"
+#include "img_trans/net/TRecv.hpp"
+#include "img_trans/net/TUdpSock.hpp"
+
+#include "utils/TLog.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#define T_LOG_TAG_IMG "[Packet Source] "
+
+using namespace std;
+
+namespace gentau {
+namespace {
+using Header        = TPacketHeader;
+using WallTimePoint = TVidRender::WallTimePoint;
+
+constexpr timeval kRecvTimeout    = { 0, 1'000 };  // 1ms, bounds a blocking read()
+constexpr i32     kRecvBufferSize = 4 * 1024 * 1024;
+
+WallTimePoint nsToWallTime(i64 ns) noexcept
+{
+	if (ns == 0) { return {}; }
+	return WallTimePoint(chrono::duration_cast<WallTimePoint::duration>(chrono::nanoseconds(ns)));
+}
+
+WallTimePoint parseRxTime([[maybe_unused]] msghdr& msg) noexcept
+{
+#ifdef SO_TIMESTAMPNS
+	for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+		if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_TIMESTAMPNS) { continue; }
+
+		timespec ts;
+		memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+		return nsToWallTime(static_cast<i64>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec);
+	}
+#endif
+	return {};
+}
+}  // namespace
+
+TUdpPacketSource::TUdpPacketSource(
+	u16 port, const char* ip, u32 batchSize, bool _kernelTimestamps, u32 maxDatagramLen
+) :
+	kernelTimestamps(_kernelTimestamps)
+{
+	batchSize      = clamp<u32>(batchSize, 1, maxBatchSize);
+	maxDatagramLen = max<u32>(maxDatagramLen, sizeof(Header));
+
+	packets.resize(static_cast<size_t>(batchSize) * maxDatagramLen);
+	slots.resize(batchSize);
+	iovs.resize(batchSize);
+	msgs.resize(batchSize);
+
+	for (u32 i = 0; i < batchSize; i++) {
+		iovs[i].iov_base = packets.data() + static_cast<size_t>(i) * maxDatagramLen;
+		iovs[i].iov_len  = maxDatagramLen;
+
+		msgs[i]                     = {};
+		msgs[i].msg_hdr.msg_iov     = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen  = 1;
+		msgs[i].msg_hdr.msg_control = kernelTimestamps ? slots[i].ctrl.data() : nullptr;
+	}
+
+	auto v4Addr = TRecv::V4Addr::create(ip, port);
+	if (!v4Addr.has_value()) {
+		tImgTransLogError("Invalid IP address: {}:{}", ip, port);
+		return;
+	}
+
+	auto sock = TUdpSock::bindV4(TUdpSock::makeV4Addr(v4Addr->ip, v4Addr->port));
+	if (sock < 0) {
+		tImgTransLogError(
+			"Failed to bind socket to {}, error: {}",
+			v4Addr->toString(),
+			error_code(-sock, system_category()).message()
+		);
+		return;
+	}
+
+	// Best effort, the defaults are fine apart from bursts
+	TUdpSock::setRecvTimeout(sock, kRecvTimeout);
+	TUdpSock::setRecvBuffer(sock, kRecvBufferSize);
+
+	if (auto granted = TUdpSock::getRecvBuffer(sock); granted.value_or(0) < kRecvBufferSize) {
+		tImgTransLogWarn(
+			"Socket receive buffer clamped to {} bytes instead of {}, raise net.core.rmem_max "
+			"to absorb bursts.",
+			granted.value_or(0),
+			kRecvBufferSize
+		);
+	}
+
+	if (kernelTimestamps) { TUdpSock::enableTimestamps(sock); }
+
+	fd = sock;
+	tImgTransLogInfo("UDP packet source bound to {}", v4Addr->toString());
+}
+
+TUdpPacketSource::~TUdpPacketSource()
+{
+	if (fd > -1) { ::close(fd); }
+}
+
+i32 TUdpPacketSource::read(std::span<TPacket> out)
+{
+	if (fd < 0) { return -EBADF; }
+
+	auto count = static_cast<u32>(min<size_t>(out.size(), msgs.size()));
+	if (count == 0) { return 0; }
+
+	if (kernelTimestamps) {
+		for (u32 i = 0; i < count; i++) { msgs[i].msg_hdr.msg_controllen = sizeof(Slot::ctrl); }
+	}
+
+	// Block for the first datagram only (bounded by SO_RCVTIMEO), then take what is queued
+	auto ret = ::recvmmsg(fd, msgs.data(), count, MSG_WAITFORONE, nullptr);
+	if (ret < 0) {
+		auto err = errno;
+		if (err == EAGAIN || err == EWOULDBLOCK || err == EINTR || err == ENOMEM) { return 0; }
+		return -err;
+	}
+
+	i32 n = 0;
+	for (i32 i = 0; i < ret; i++) {
+		auto len = msgs[i].msg_len;
+		if (len == 0) [[unlikely]] { continue; }
+
+		auto packet = static_cast<u8*>(iovs[i].iov_base);
+		out[n++]    = { std::span(packet, len), parseRxTime(msgs[i].msg_hdr) };
+	}
+
+	return n;
+}
+
+void TMemPacketSource::append(std::span<const u8> packet, WallTimePoint rxTime)
+{
+	Entry entry{ storage.size(), static_cast<u32>(packet.size()), 0, false, rxTime };
+
+	if (auto header = Header::parse(packet)) {
+		entry.frameIdx  = header->frameIdx;
+		entry.shiftable = true;
+
+		if (!firstFrameIdx.has_value()) { firstFrameIdx = entry.frameIdx; }
+
+		auto ahead = Header::diff(entry.frameIdx, firstFrameIdx.value());
+		if (ahead >= 0 && static_cast<u32>(ahead) + 1 > frameIdxStride) {
+			frameIdxStride = static_cast<u16>(ahead + 1);
+		}
+	}
+
+	storage.insert(storage.end(), packet.begin(), packet.end());
+	entries.push_back(entry);
+}
+
+i64 TMemPacketSource::appendFrom(TPacketSource& source, u64 maxPackets)
+{
+	array<TPacket, TPacketFeeder::batchSize> batch;
+
+	u64 appended = 0;
+	while (appended < maxPackets) {
+		auto want = min<u64>(batch.size(), maxPackets - appended);
+		auto ret  = source.read(std::span(batch).first(want));
+
+		if (ret < 0) { return ret; }
+		if (ret == 0 && source.isExhausted()) { break; }
+
+		for (i32 i = 0; i < ret; i++) { append(batch[i].data, batch[i].rxTime); }
+		appended += static_cast<u64>(ret);
+	}
+
+	return static_cast<i64>(appended);
+}
+
+void TMemPacketSource::setLoops(u64 _loops, bool _shiftFrameIdx) noexcept
+{
+	loops         = max<u64>(_loops, 1);
+	shiftFrameIdx = _shiftFrameIdx;
+	rewind();
+}
+
+void TMemPacketSource::rewind() noexcept
+{
+	curLoop = 0;
+	cursor  = 0;
+}
+
+i32 TMemPacketSource::read(std::span<TPacket> out)
+{
+	i32 n = 0;
+
+	while (static_cast<size_t>(n) < out.size() && !isExhausted()) {
+		if (cursor >= entries.size()) {
+			// The next pass rewrites the frame indices in place, under the spans already in `out`
+			if (n > 0) { break; }
+
+			cursor = 0;
+			curLoop++;
+			continue;
+		}
+
+		const auto& entry  = entries[cursor++];
+		u8*         packet = storage.data() + entry.offset;
+
+		if (entry.shiftable) {
+			// Rewritten on every pass, so switching shifting off restores the appended indices
+			u16 idx = entry.frameIdx;
+			if (shiftFrameIdx) { idx += static_cast<u16>(curLoop * frameIdxStride); }
+			memcpy(packet + offsetof(Header, frameIdx), &idx, sizeof(idx));
+		}
+
+		out[n++] = { std::span(packet, entry.len), entry.rxTime };
+	}
+
+	return n;
+}
+
+TCapturePacketSource::TCapturePacketSource(const std::string& path)
+{
+	auto fileFd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fileFd < 0) {
+		tImgTransLogError(
+			"Failed to open capture file '{}', error: {}",
+			path,
+			error_code(errno, system_category()).message()
+		);
+		return;
+	}
+
+	struct stat st{};
+	if (::fstat(fileFd, &st) < 0 ||
+		static_cast<u64>(st.st_size) < sizeof(TCaptureFormat::FileHeader)) {
+		tImgTransLogError("Capture file '{}' is too small or can not be inspected", path);
+		::close(fileFd);
+		return;
+	}
+
+	auto len = static_cast<u64>(st.st_size);
+
+	// Copy-on-write, so the datagrams can be handed out as mutable spans without a copy
+	auto addr = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileFd, 0);
+
+	[[maybe_unused]] auto err = errno;
+	::close(fileFd);  // The mapping keeps its own reference to the file
+
+	if (addr == MAP_FAILED) {
+		tImgTransLogError(
+			"Failed to map capture file '{}', error: {}",
+			path,
+			error_code(err, system_category()).message()
+		);
+		return;
+	}
+
+	TCaptureFormat::FileHeader header;
+	memcpy(&header, addr, sizeof(header));
+
+	if (memcmp(header.magic, TCaptureFormat::magic, sizeof(header.magic)) != 0 ||
+		header.version != TCaptureFormat::version) {
+		tImgTransLogError(
+			"'{}' is not a capture file of version {}", path, TCaptureFormat::version
+		);
+		::munmap(addr, len);
+		return;
+	}
+
+	::madvise(addr, len, MADV_SEQUENTIAL);
+
+	mapped  = static_cast<u8*>(addr);
+	fileLen = len;
+	rewind();
+
+	tImgTransLogInfo("Capture file '{}' opened, {} bytes", path, fileLen);
+}
+
+TCapturePacketSource::~TCapturePacketSource()
+{
+	if (mapped) { ::munmap(mapped, fileLen); }
+}
+
+bool TCapturePacketSource::isExhausted() const noexcept
+{
+	return !mapped || cursor + sizeof(TCaptureFormat::RecordHeader) > fileLen;
+}
+
+i32 TCapturePacketSource::read(std::span<TPacket> out)
+{
+	i32 n = 0;
+
+	while (static_cast<size_t>(n) < out.size() && !isExhausted()) {
+		TCaptureFormat::RecordHeader record;
+		memcpy(&record, mapped + cursor, sizeof(record));
+
+		auto dataOffset = cursor + sizeof(record);
+		if (record.len > fileLen - dataOffset) [[unlikely]] {
+			tImgTransLogWarn("Truncated capture record at offset {}, replay ends here", cursor);
+			cursor = fileLen;
+			break;
+		}
+
+		if (pacing == Pacing::RECORDED) {
+			auto now = chrono::steady_clock::now();
+			if (replayStart == TimePoint::min()) { replayStart = now; }
+
+			auto offset = chrono::nanoseconds(static_cast<i64>(record.arrivalNs / speed));
+			auto due    = replayStart + chrono::duration_cast<TimePoint::duration>(offset);
+
+			if (now < due) {
+				if (n > 0) { break; }  // Hand out what is due now, wait on the next read()
+
+				this_thread::sleep_until(min(due, now + maxPaceSleep));
+				if (chrono::steady_clock::now() < due) { break; }
+			}
+		}
+
+		cursor = dataOffset + TCaptureFormat::paddedLen(record.len);
+
+		if (record.len == 0) [[unlikely]] { continue; }
+
+		out[n++] = { std::span(mapped + dataOffset, record.len), nsToWallTime(record.rxTimeNs) };
+	}
+
+	return n;
+}
+
+template<typename Policy>
+TBasicPacketFeeder<Policy>::TBasicPacketFeeder(ReassemblerPtr _reassembler) :
+	reassembler(std::move(_reassembler))
+{
+	if (!reassembler) {
+		constexpr auto errMsg = "Reassembler cannot be nullptr"sv;
+		tImgTransLogError("{}", errMsg);
+		throw std::invalid_argument(errMsg.data());
+	}
+}
+
+template<typename Policy>
+TBasicPacketFeeder<Policy>::~TBasicPacketFeeder() = default;
+
+template<typename Policy>
+void TBasicPacketFeeder<Policy>::setImpairment(const TImpairmentOptions& options)
+{
+	impairment.reset();
+	if (options.isEnabled()) { impairment = TImpairment::create(options, Reassembly::mtuLen); }
+}
+
+template<typename Policy>
+void TBasicPacketFeeder<Policy>::deliver(const TPacket& packet)
+{
+	if (!impairment) {
+		reassembler->onPacketRecv(packet.data, packet.rxTime, {});
+		return;
+	}
+
+	auto now = chrono::steady_clock::now();
+	releaseImpaired(now);
+
+	if (impairment->submit(packet.data, packet.rxTime, now) == TImpairment::Verdict::PASS) {
+		reassembler->onPacketRecv(packet.data, packet.rxTime, {});
+	}
+}
+
+template<typename Policy>
+void TBasicPacketFeeder<Policy>::releaseImpaired(chrono::steady_clock::time_point now)
+{
+	TPacket held;
+	while (impairment->popDue(now, held)) {
+		reassembler->onPacketRecv(held.data, held.rxTime, {});
+	}
+}
+
+template<typename Policy>
+void TBasicPacketFeeder<Policy>::onTimerDue(chrono::steady_clock::time_point now)
+{
+	if (impairment) { releaseImpaired(now); }
+
+	reassembler->ReAsmSlotScan({});
+}
+
+template<typename Policy>
+auto TBasicPacketFeeder<Policy>::nextTimerDeadline() const noexcept
+	-> chrono::steady_clock::time_point
+{
+	auto deadline = reassembler->nextScanDeadline({});
+	if (impairment) { deadline = min(deadline, impairment->nextRelease()); }
+
+	return deadline;
+}
+
+template<typename Policy>
+auto TBasicPacketFeeder<Policy>::feed(TPacketSource& source, std::stop_token sToken, u64 maxPackets)
+	-> FeedStats
+{
+	FeedStats stats;
+
+	array<TPacket, batchSize> batch;
+
+	auto start     = chrono::steady_clock::now();
+	auto nextTimer = nextTimerDeadline();
+
+	while (!sToken.stop_requested() && stats.packets < maxPackets) {
+		auto want = min<u64>(batch.size(), maxPackets - stats.packets);
+		auto ret  = source.read(std::span(batch).first(want));
+
+		if (ret < 0) {
+			tImgTransLogError(
+				"Packet source failed, error: {}", error_code(-ret, system_category()).message()
+			);
+			break;
+		}
+
+		if (ret == 0 && source.isExhausted()) { break; }
+
+		for (i32 i = 0; i < ret; i++) {
+			deliver(batch[i]);
+			stats.bytes += batch[i].data.size();
+		}
+
+		if (ret > 0) {
+			stats.packets += static_cast<u64>(ret);
+			stats.reads++;
+		}
+
+		// Same timer handling as the receiving thread of TRecv, checked after every read, empty
+		// ones included, so held datagrams leave on time through idle periods too
+		if (auto now = chrono::steady_clock::now(); now >= nextTimer) { onTimerDue(now); }
+		nextTimer = nextTimerDeadline();
+	}
+
+	// Drain the datagrams the impairment stage and the jitter buffer still hold
+	while ((impairment && impairment->getHeldCount() > 0) ||
+		   reassembler->heldFrameCount({}) > 0) {
+		if (sToken.stop_requested()) { break; }
+
+		this_thread::sleep_until(nextTimer);
+
+		onTimerDue(chrono::steady_clock::now());
+		nextTimer = nextTimerDeadline();
+	}
+
+	stats.elapsed = chrono::steady_clock::now() - start;
+
+	tImgTransLogDebug(
+		"Fed {} datagrams in {} reads, {:.0f} datagrams/s, {:.1f} Mbit/s",
+		stats.packets,
+		stats.reads,
+		stats.packetsPerSec(),
+		stats.megabitsPerSec()
+	);
+
+	return stats;
+}
+
+template class TBasicPacketFeeder<TDefaultReAsmPolicy>;
+template class TBasicPacketFeeder<TSmallMtuReAsmPolicy>;
+template class TBasicPacketFeeder<TJumboReAsmPolicy>;
+}  // namespace gentau
@@ -1,4 +1,5 @@
 #include "img_trans/net/TReassembly.hpp"
+#include "img_trans/net/THevcNal.hpp"
 
 #include "img_trans/vid_render/TFramePool.hpp"
 
@@ -6,9 +7,13 @@
 
 #include "conf/version.hpp"
 
+#include <algorithm>
+#include <bit>
 #include <chrono>
 #include <cstring>
+#include <string>
 #include <string_view>
+#include <utility>
 
 #define T_LOG_TAG_IMG "[Reassembler] "
 
@@ -16,7 +21,9 @@ using namespace std;
 using namespace std::literals;
 
 namespace gentau {
-TReassembly::TReassembly(TVidRender::SharedPtr _renderer) : renderer(std::move(_renderer))
+template<typename Policy>
+TBasicReassembly<Policy>::TBasicReassembly(TVidRender::SharedPtr _renderer) :
+	renderer(std::move(_renderer))
 {
 	if constexpr (!conf::TDebugMode) {
 		if (renderer == nullptr) {
@@ -34,90 +41,199 @@ TReassembly::TReassembly(TVidRender::SharedPtr _renderer) : renderer(std::move(_
 	}
 }
 
-bool TReassembly::ReassemblingFrame::fill(std::span<u8> packet, const Header* header)
+template<typename Policy>
+u8* TBasicReassembly<Policy>::ReassemblingFrame::fillTarget(u16 secIdx, u32 payloadSize) noexcept
 {
-	if (!isOccupied() || isComplete()) { return false; }
+	if (!isOccupied() || isComplete()) { return nullptr; }
 
+	if (secIdx >= expectedSecs || payloadSize == 0) { return nullptr; }
+
+	if (hasSection(secIdx)) { return nullptr; }
+
+	// Completion counts sections, so a section must carry exactly its share of the frame
+	if (payloadSize != sectionLen(secIdx)) { return nullptr; }
+
+	u8* destPtr = frameSlot.data();
+	if (!destPtr) { return nullptr; }
+
+	return destPtr + secIdx * maxPayloadSize;
+}
+
+template<typename Policy>
+u32 TBasicReassembly<Policy>::ReassemblingFrame::findSection(
+	u32 from, bool received
+) const noexcept
+{
+	const u32 words = (expectedSecs + 63) / 64;
+
+	for (u32 w = from / 64; w < words; w++) {
+		u64 word = received ? receivedSecs[w] : ~receivedSecs[w];
+		if (w == from / 64) { word &= ~u64{ 0 } << (from % 64); }
+
+		// The bits past `expectedSecs` are clear, so inverted they read as missing: clamp
+		if (word != 0) { return min(w * 64 + static_cast<u32>(countr_zero(word)), expectedSecs); }
+	}
+
+	return expectedSecs;
+}
+
+template<typename Policy>
+u32 TBasicReassembly<Policy>::ReassemblingFrame::missingRanges(
+	std::span<SectionRange> out
+) const noexcept
+{
+	u32 ranges = 0;
+
+	for (u32 sec = findSection(0, false); sec < expectedSecs;) {
+		u32 end = findSection(sec, true);
+
+		if (ranges < out.size()) {
+			out[ranges] = { static_cast<u16>(sec), static_cast<u16>(end - sec) };
+		}
+		ranges++;
+
+		sec = findSection(end, false);
+	}
+
+	return ranges;
+}
+
+template<typename Policy>
+bool TBasicReassembly<Policy>::ReassemblingFrame::fill(
+	std::span<u8> packet, const Header* header, WallTimePoint rxTime
+)
+{
 	if (packet.empty() || header == nullptr) { return false; }
 
 	auto packetLen = static_cast<u32>(packet.size());
 
 	u16 secIdx      = header->secIdx;
-	u32 offset      = secIdx * maxPayloadSize;
 	u32 payloadSize = packetLen < sizeof(Header) ? 0 : packetLen - sizeof(Header);
-	u32 frameLen    = frameSlot->getDataLen();
-	u8* destPtr     = frameSlot->data();
-
-	// tImgTransLogDebug("secIdx {} | offset {} | payloadSize {} | frameLen {}", secIdx, offset, payloadSize, frameLen);
 
-	if (secIdx >= receivedSecs.size() || payloadSize == 0) { return false; }
-
-	if (receivedSecs.test(secIdx)) { return false; }
-
-	if (offset + payloadSize > frameLen) { return false; }
+	// tImgTransLogDebug("secIdx {} | payloadSize {}", secIdx, payloadSize);
 
+	u8* destPtr = fillTarget(secIdx, payloadSize);
 	if (!destPtr) { return false; }
 
-	memcpy(destPtr + offset, packet.data() + sizeof(Header), payloadSize);
-	receivedSecs.set(secIdx);
-	curLen += payloadSize;
+	memcpy(destPtr, packet.data() + sizeof(Header), payloadSize);
+	markFilled(secIdx, payloadSize, rxTime);
 
 	// tImgTransLogDebug("curLen {}", curLen);
 
 	return true;
 }
 
-auto TReassembly::findReAsmSlot(u16 idx) -> ReassemblingFrame*
+template<typename Policy>
+u32 TBasicReassembly<Policy>::EvictPolicy::pickVictim(
+	const std::array<ReassemblingFrame, reAsmWindow>& table, u64 liveMask
+) noexcept
 {
-	ReassemblingFrame* firstEmpty  = nullptr;
-	ReassemblingFrame* oldestSmall = nullptr;
-	ReassemblingFrame* oldestLarge = nullptr;
+	u32 oldestSmall = reAsmWindow;
+	u32 oldestLarge = reAsmWindow;
 
 	auto minTimeSmall = TimePoint::max();
 	auto minTimeLarge = TimePoint::max();
 
-	for (auto& frame : rFrames) {
-		if (frame.isOccupied() && frame.frameIdx == idx) { return &frame; }
+	for (u64 mask = liveMask; mask != 0; mask &= mask - 1) {
+		auto        pos   = static_cast<u32>(countr_zero(mask));
+		const auto& frame = table[pos];
 
-		if (!frame.isOccupied()) {
-			if (!firstEmpty) { firstEmpty = &frame; }
-		} else {
-			bool isLarge = frame.frameSlot->getDataLen() >= bigFrameThres;
-
-			if (isLarge) {
-				if (frame.asmStartTime < minTimeLarge) {
-					minTimeLarge = frame.asmStartTime;
-					oldestLarge  = &frame;
-				}
-			} else {
-				if (frame.asmStartTime < minTimeSmall) {
-					minTimeSmall = frame.asmStartTime;
-					oldestSmall  = &frame;
-				}
+		if (frame.frameSlot.getDataLen() >= bigFrameThres) {
+			if (frame.asmStartTime < minTimeLarge) {
+				minTimeLarge = frame.asmStartTime;
+				oldestLarge  = pos;
 			}
+		} else if (frame.asmStartTime < minTimeSmall) {
+			minTimeSmall = frame.asmStartTime;
+			oldestSmall  = pos;
 		}
 	}
 
-	if (firstEmpty) { return firstEmpty; }
+	return oldestSmall != reAsmWindow ? oldestSmall : oldestLarge;
+}
+
+template<typename Policy>
+auto TBasicReassembly<Policy>::findReAsmSlot(u16 idx) -> ReassemblingFrame*
+{
+	auto  pos   = slotPos(idx);
+	auto& entry = rFrames[pos];
+
+	if (liveMask & (u64{ 1 } << pos)) {
+		if (entry.frameIdx == idx) [[likely]] { return &entry; }
+
+		if (!EvictPolicy::yieldsTo(entry, idx)) { return nullptr; }
+	}
+
+	return &entry;
+}
+
+template<typename Policy>
+void TBasicReassembly<Policy>::claimReAsmSlot(u16 idx)
+{
+	auto pos = slotPos(idx);
+
+	if (liveMask & (u64{ 1 } << pos)) {
+		tImgTransLogDebug("Dropping frame {} for frame {} in its slot", rFrames[pos].frameIdx, idx);
+		countEviction(rFrames[pos]);
+		releaseReAsmSlot(pos);
+	}
 
 	// 如果网络状况极差，可能需要加入额外的 Header::isAfter 判断，但这种判断可能会导致僵尸帧无法被
 	// 正常清理，这里暂时保持抢占式清理策略即可
-	if (oldestSmall) {
-		tImgTransLogWarn("Dropping oldest SMALL frame: {}", oldestSmall->frameIdx);
-		oldestSmall->clear();
-		return oldestSmall;
+	if (static_cast<u32>(popcount(liveMask)) >= maxReAsmSlots) {
+		auto victim = EvictPolicy::pickVictim(rFrames, liveMask);
+
+		tImgTransLogDebug(
+			"Dropping oldest {} frame: {}",
+			rFrames[victim].frameSlot.getDataLen() >= bigFrameThres ? "LARGE" : "SMALL",
+			rFrames[victim].frameIdx
+		);
+		countEviction(rFrames[victim]);
+		releaseReAsmSlot(victim);
 	}
+}
 
-	if (oldestLarge) {
-		tImgTransLogWarn("Dropping oldest LARGE frame: {}", oldestLarge->frameIdx);
-		oldestLarge->clear();
-		return oldestLarge;
+template<typename Policy>
+void TBasicReassembly<Policy>::TimeoutEstimator::addStart(TimePoint start) noexcept
+{
+	if (lastStart != TimePoint::min() && start > lastStart) {
+		auto us = chrono::duration_cast<chrono::microseconds>(start - lastStart).count();
+		intervalUs[intervals++ % window] = static_cast<u32>(min<i64>(us, UINT32_MAX));
 	}
 
-	return nullptr;
+	lastStart = start;
+}
+
+template<typename Policy>
+void TBasicReassembly<Policy>::TimeoutEstimator::addSpread(TimePoint::duration spread) noexcept
+{
+	auto us = chrono::duration_cast<chrono::microseconds>(spread).count();
+	spreadUs[spreads++ % window] = static_cast<u32>(clamp<i64>(us, 0, UINT32_MAX));
 }
 
-void TReassembly::onPacketRecv(std::span<u8> packetData, TRecvPasskey)
+template<typename Policy>
+auto TBasicReassembly<Policy>::TimeoutEstimator::estimate() const noexcept -> TimePoint::duration
+{
+	auto percentile = [](const std::array<u32, window>& samples, u32 count, f32 q) -> u32 {
+		if (count == 0) { return 0; }
+
+		std::array<u32, window> sorted;
+		count = min(count, window);
+		copy_n(samples.begin(), count, sorted.begin());
+
+		auto nth = sorted.begin() + static_cast<u32>(q * static_cast<f32>(count - 1));
+		nth_element(sorted.begin(), nth, sorted.begin() + count);
+		return *nth;
+	};
+
+	auto spread   = percentile(spreadUs, spreads, spreadPercentile);
+	auto interval = percentile(intervalUs, intervals, 0.5f);
+
+	return chrono::microseconds(static_cast<i64>(headroom * static_cast<f32>(spread)) + interval);
+}
+
+template<typename Policy>
+auto TBasicReassembly<Policy>::admitPacket(const Header* header) -> ReassemblingFrame*
 {
 	auto now = chrono::steady_clock::now();
 	if (synced.load() && now - lastSyncedTime.load() > syncTimeout) {
@@ -125,23 +241,21 @@ void TReassembly::onPacketRecv(std::span<u8> packetData, TRecvPasskey)
 		synced.store(false);
 	}
 
-	if (packetData.empty() || packetData.size() < sizeof(Header)) {
-		tImgTransLogWarn("Received packet too small to contain valid header, ignoring.");
-		return;
-	}
-
-	auto header = Header::parse(packetData);
-	if (!header) {
-		tImgTransLogWarn("Received packet with invalid header, ignoring.");
-		return;
-	}
-
 	if (header->frameLen > TFramePool::slotLen) {
 		tImgTransLogWarn(
 			"Received packet with frame length {} exceeding slot capacity, ignoring.",
 			header->frameLen
 		);
-		return;
+		return nullptr;
+	}
+
+	if (header->frameLen == 0 || sectionCount(header->frameLen) > maxSecPerFrame) {
+		tImgTransLogWarn(
+			"Received packet with frame length {} not fitting in {} sections, ignoring.",
+			header->frameLen,
+			maxSecPerFrame
+		);
+		return nullptr;
 	}
 
 	auto frameIdxDiff = Header::diff(header->frameIdx, lastPushedIdx.load());
@@ -157,17 +271,33 @@ void TReassembly::onPacketRecv(std::span<u8> packetData, TRecvPasskey)
 		synced.store(false);
 	}
 
-	if (synced.load() && frameIdxDiff <= 0) {
-		return;
-	}  // Drop likely normal duplicate or out-of-order packet
+	// Drop likely normal duplicate or out-of-order packet. A frame in the jitter buffer is
+	// finished too, although lastPushedIdx has not passed it yet.
+	if (synced.load() && (frameIdxDiff <= 0 || (heldCount > 0 && isHeld(header->frameIdx)))) {
+		telemetry.add(TReAsmTelemetry::Counter::STALE_PACKETS);
+		return nullptr;
+	}
 
 	if (!synced.load()) {
+		if (lastSyncedTime.load() != TimePoint::min()) {
+			telemetry.add(TReAsmTelemetry::Counter::RESYNCS);
+		}
 		synced.store(true);
 
 		// set to one before current. It's ok to overflow.
 		lastPushedIdx.store(header->frameIdx - 1);
 
-		for (auto& frame : rFrames) { frame.clear(); }  // Clear all reassembly frames when de-sync.
+		// The decoder can not pick up a new session in the middle of a GOP either
+		lastHandledIdx = header->frameIdx - 1;
+		skippedFrames  = 0;
+		recovery.store(RecoveryState::AWAIT_IRAP);
+		paramSetsDue = true;
+
+		for (u32 i = 0; i < heldCount; i++) { heldFrames[i] = {}; }
+		heldCount = 0;
+
+		// Clear all reassembly frames when de-sync.
+		for (u32 pos = 0; pos < reAsmWindow; pos++) { releaseReAsmSlot(pos); }
 
 		tImgTransLogDebug("Session synced at frame {}, sec {}.", header->frameIdx, header->secIdx);
 	}
@@ -175,60 +305,494 @@ void TReassembly::onPacketRecv(std::span<u8> packetData, TRecvPasskey)
 
 	auto rSlot = findReAsmSlot(header->frameIdx);
 	if (!rSlot) [[unlikely]] {
-		tImgTransLogWarn(
+		tImgTransLogDebug(
 			"No available reassembly slot for frame {}, dropping packet.", header->frameIdx
 		);
-		return;
+		telemetry.add(TReAsmTelemetry::Counter::NO_REASM_SLOT);
+		return nullptr;
 	}
 
-	if (!rSlot->isOccupied()) {
-		auto frameDataOpt = renderer->acquireFrameSlot({});
-		if (!frameDataOpt.has_value()) { return; }
+	if (!rSlot->isOccupied() || rSlot->frameIdx != header->frameIdx) {
+		// Acquire before evicting, a live frame is only dropped once the new one has a slot
+		auto frameDataOpt = renderer->acquireFrameSlot(header->frameLen, {});
+		if (!frameDataOpt.has_value()) {
+			// The decoder holds on to too many frames, see TVidRender::getFramePoolStats()
+			tImgTransLogDebug(
+				"No free frame slot for frame {}, dropping packet.", header->frameIdx
+			);
+			telemetry.add(TReAsmTelemetry::Counter::POOL_EXHAUSTED);
+			return nullptr;
+		}
+
+		claimReAsmSlot(header->frameIdx);
 
 		rSlot->frameSlot = std::move(frameDataOpt).value();
-		rSlot->frameSlot->setDataLen(header->frameLen);
+		rSlot->frameSlot.setDataLen(header->frameLen);
 
 		rSlot->frameIdx     = header->frameIdx;
+		rSlot->expectedSecs = sectionCount(header->frameLen);
 		rSlot->asmStartTime = now;
+
+		liveMask |= u64{ 1 } << slotPos(header->frameIdx);
+
+		if (adaptiveTimeoutEnabled()) { timeoutEstimator.addStart(now); }
+	}
+
+	return rSlot;
+}
+
+template<typename Policy>
+auto TBasicReassembly<Policy>::inspectAccessUnit(std::span<const u8> au) noexcept -> AccessUnitInfo
+{
+	AccessUnitInfo info;
+
+	TAnnexBScanner scanner(au);
+	THevcNal       nal;
+	THevcNal       prev;
+
+	// The end of a NAL unit is only known once the next start code is found
+	for (bool hasPrev = false; scanner.next(nal); prev = nal, hasPrev = true) {
+		if (hasPrev && prev.type == THevcNal::AUD_NUT) { info.insertAt = nal.start; }
+
+		if (hasPrev && prev.isParamSet()) {
+			info.paramSets[prev.type - THevcNal::VPS_NUT] =
+				au.subspan(prev.start, nal.start - prev.start);
+		}
+
+		if (nal.isVcl()) {
+			info.vclType = nal.type;
+			break;
+		}
+	}
+
+	return info;
+}
+
+template<typename Policy>
+void TBasicReassembly<Policy>::cacheParamSets(const AccessUnitInfo& info) noexcept
+{
+	for (u32 i = 0; i < paramSetCache.size(); i++) {
+		auto nal = info.paramSets[i];
+		if (nal.empty()) { continue; }
+
+		if (nal.size() > maxParamSetLen) {
+			tImgTransLogDebug("Parameter set of {} bytes is too long to be cached.", nal.size());
+			continue;
+		}
+
+		memcpy(paramSetCache[i].data(), nal.data(), nal.size());
+		paramSetLens[i] = static_cast<u32>(nal.size());
+	}
+}
+
+template<typename Policy>
+bool TBasicReassembly<Policy>::injectParamSets(
+	TFramePool::FrameData& frame, const AccessUnitInfo& info
+) noexcept
+{
+	const u8* base = frame.data();  // The spans of `info` point into the frame as inspected
+
+	// A missing set goes right after the last lower-typed set the frame carries, or at
+	// `insertAt`, so the VPS, SPS, PPS order holds whichever of them are present
+	auto insertPos = [&](u32 type) {
+		u32 pos = info.insertAt;
+		for (u32 i = 0; i < type; i++) {
+			auto nal = info.paramSets[i];
+			if (!nal.empty()) { pos = max(pos, static_cast<u32>(nal.data() + nal.size() - base)); }
+		}
+		return pos;
+	};
+
+	u32 extra = 0;
+	for (u32 i = 0; i < paramSetCache.size(); i++) {
+		if (info.paramSets[i].empty()) { extra += paramSetLens[i]; }
+	}
+
+	if (extra == 0) { return true; }  // The frame carries its own, or nothing is cached yet
+
+	u32 len = frame.getDataLen();
+	if (len + extra > frame.capacity()) {
+		// The slot was sized for the frame alone, move it into one of the next size class
+		auto largerOpt = renderer->acquireFrameSlot(len + extra, {});
+		if (!largerOpt.has_value()) {
+			tImgTransLogWarn(
+				"No room to prepend {} bytes of parameter sets to the keyframe.", extra
+			);
+			return false;
+		}
+
+		memcpy(largerOpt->data(), frame.data(), len);
+		largerOpt->setDataLen(len);
+		frame = std::move(largerOpt).value();
+	}
+
+	// From the back, shift each run of the frame by the sets inserted in front of it
+	u8* data  = frame.data();
+	u32 shift = extra;
+	u32 end   = len;
+	for (u32 i = paramSetCache.size(); i-- > 0;) {
+		if (!info.paramSets[i].empty() || paramSetLens[i] == 0) { continue; }
+
+		u32 pos = insertPos(i);
+		memmove(data + pos + shift, data + pos, end - pos);
+		shift -= paramSetLens[i];
+		memcpy(data + pos + shift, paramSetCache[i].data(), paramSetLens[i]);
+		end = pos;
+	}
+
+	frame.setDataLen(len + extra);
+	tImgTransLogDebug("Inserted {} bytes of cached parameter sets into the keyframe.", extra);
+	return true;
+}
+
+template<typename Policy>
+bool TBasicReassembly<Policy>::preparePush(
+	u16 frameIdx, TFramePool::FrameData& frame, bool complete
+)
+{
+	bool decoderReset = false;
+	if (auto resets = renderer->getDecoderResetCount(); resets != decoderResets) {
+		decoderResets = resets;
+		decoderReset  = true;
+		paramSetsDue  = true;
+	}
+
+	// The holes of an incomplete frame that was not truncated still hold bytes of the slot's
+	// previous frame, a start code found there may be stale. Such a frame counts as non-IRAP:
+	// it can not end the recovery, and gets no parameter sets.
+	AccessUnitInfo info;
+	if (complete || incompleteTruncated()) {
+		info = inspectAccessUnit({ frame.data(), frame.getDataLen() });
+	}
+
+	// A parameter set in an incomplete frame may be cut by a hole
+	if (complete) { cacheParamSets(info); }
+
+	if (!passRecoveryGate(frameIdx, info.vclType, decoderReset)) { return false; }
+
+	if (paramSetsDue && THevcNal::isIrap(info.vclType)) {
+		paramSetsDue = !injectParamSets(frame, info);
 	}
 
-	if (rSlot->fill(packetData, header)) {
-		if (rSlot->isComplete()) {
-			renderer->tryPushFrame(rSlot->steal(), {});
-			lastPushedIdx.store(header->frameIdx);
+	return true;
+}
+
+template<typename Policy>
+bool TBasicReassembly<Policy>::passRecoveryGate(u16 frameIdx, u8 vclType, bool decoderReset)
+{
+	bool gap   = Header::diff(frameIdx, std::exchange(lastHandledIdx, frameIdx)) > 1;
+	auto state = recovery.load();
 
-			rSlot->clear();  // Reset metadata, the actual frame has been moved.
+	if (!keyframeRecoveryEnabled()) {
+		if (state != RecoveryState::NONE) { recovery.store(RecoveryState::NONE); }
+		return true;
+	}
 
-			// for (auto& frame : rFrames) {
-			// 	if ((frame.isOccupied() && Header::isBefore(frame.frameIdx, header->frameIdx)) ||
-			// 		frame.frameIdx == header->frameIdx) {
-			// 		frame.clear();
-			// 	}
-			// }
+	if ((gap || decoderReset) && state != RecoveryState::AWAIT_IRAP) {
+		tImgTransLogDebug("Frame gap before frame {}, skipping until the next keyframe.", frameIdx);
+		state         = RecoveryState::AWAIT_IRAP;
+		skippedFrames = 0;
+	}
 
-			// Note: 这里的激进清理可能会导致一些边缘情况的帧被过早丢弃，暂时先不启用。
-			// 找重组槽位时的抢占式清理与重组超时检查已经能够在大多数情况下保证僵尸帧不
-			// 会过多积累，且不会过早丢弃正常帧。
+	if (state == RecoveryState::NONE) { return true; }
+
+	bool pass = false;
+	if (state == RecoveryState::AWAIT_IRAP) {
+		pass = THevcNal::isIrap(vclType);
+		if (pass) {
+			tImgTransLogInfo(
+				"Recovered at keyframe {} (NAL type {}), {} frames skipped.",
+				frameIdx,
+				vclType,
+				skippedFrames
+			);
+			state = RecoveryState::SKIP_RASL;
 		}
+	} else {
+		pass = !THevcNal::isRasl(vclType);
+		if (pass) { state = RecoveryState::NONE; }
+	}
+
+	if (!pass) { skippedFrames++; }
+	recovery.store(state);
+
+	return pass;
+}
+
+template<typename Policy>
+void TBasicReassembly<Policy>::updateTimeout(TimePoint::duration spread) noexcept
+{
+	timeoutEstimator.addSpread(spread);
+	if (!timeoutEstimator.isDue()) { return; }
+
+	auto timeout = clamp(timeoutEstimator.estimate(), minTimeout.load(), maxTimeout.load());
+	auto prev    = curTimeout.exchange(timeout);
+
+	if (prev != timeout) {
+		tImgTransLogDebug(
+			"Reassembly timeout adapted to {} us.",
+			chrono::duration_cast<chrono::microseconds>(timeout).count()
+		);
+	}
+}
+
+template<typename Policy>
+void TBasicReassembly<Policy>::deliverFrame(
+	u16 frameIdx, TFramePool::FrameData&& frame, RxTimestamps rxTs, bool complete
+)
+{
+	if (preparePush(frameIdx, frame, complete)) {
+		renderer->tryPushFrame(std::move(frame), rxTs, {});
+	}
+	lastPushedIdx.store(frameIdx);
+}
+
+template<typename Policy>
+void TBasicReassembly<Policy>::pushFrame(
+	u16 frameIdx, TFramePool::FrameData&& frame, RxTimestamps rxTs, bool complete
+)
+{
+	bool inOrder = Header::diff(frameIdx, lastPushedIdx.load()) == 1;
+
+	if (heldCount == 0 && (jitterFrames.load() == 0 || inOrder)) {
+		deliverFrame(frameIdx, std::move(frame), rxTs, complete);
+		return;
+	}
+
+	auto now = chrono::steady_clock::now();
+
+	heldFrames[heldCount++] = HeldFrame{ std::move(frame), rxTs, now, frameIdx, complete };
+	releaseHeld(now);
+}
+
+template<typename Policy>
+void TBasicReassembly<Policy>::releaseHeld(TimePoint now)
+{
+	while (heldCount > 0) {
+		u32  next   = 0;
+		auto oldest = heldFrames[0].heldAt;
+
+		for (u32 i = 1; i < heldCount; i++) {
+			if (Header::isBefore(heldFrames[i].frameIdx, heldFrames[next].frameIdx)) { next = i; }
+			oldest = min(oldest, heldFrames[i].heldAt);
+		}
+
+		auto& held = heldFrames[next];
+		auto  diff = Header::diff(held.frameIdx, lastPushedIdx.load());
+
+		// Give up on the missing frames once the buffer is full or has waited long enough
+		bool release = diff <= 1 || heldCount > jitterFrames.load() ||
+					   now - oldest >= jitterDelay.load();
+		if (!release) { break; }
+
+		if (diff > 1) {
+			tImgTransLogDebug(
+				"Jitter buffer gave up on {} frame(s) before frame {}.", diff - 1, held.frameIdx
+			);
+		}
+
+		// A frame older than the last pushed one can only be dropped
+		if (diff > 0) {
+			deliverFrame(held.frameIdx, std::move(held.frame), held.rxTs, held.complete);
+		}
+
+		held = std::move(heldFrames[--heldCount]);
+		heldFrames[heldCount] = {};
+	}
+}
+
+template<typename Policy>
+void TBasicReassembly<Policy>::pushIfComplete(ReassemblingFrame* rSlot)
+{
+	if (!rSlot->isComplete()) { return; }
+
+	auto frameIdx = rSlot->frameIdx;
+
+	auto asmTime = chrono::steady_clock::now() - rSlot->asmStartTime;
+
+	telemetry.addCompleted(chrono::duration_cast<chrono::microseconds>(asmTime));
+
+	if (adaptiveTimeoutEnabled()) { updateTimeout(asmTime); }
+
+	pushFrame(frameIdx, rSlot->steal(), rSlot->rxTs, true);
+
+	releaseReAsmSlot(slotPos(frameIdx));  // Reset metadata, the actual frame has been moved.
+
+	// for (auto& frame : rFrames) {
+	// 	if ((frame.isOccupied() && Header::isBefore(frame.frameIdx, frameIdx)) ||
+	// 		frame.frameIdx == frameIdx) {
+	// 		frame.clear();
+	// 	}
+	// }
+
+	// Note: 这里的激进清理可能会导致一些边缘情况的帧被过早丢弃，暂时先不启用。
+	// 找重组槽位时的抢占式清理与重组超时检查已经能够在大多数情况下保证僵尸帧不
+	// 会过多积累，且不会过早丢弃正常帧。
+}
+
+template<typename Policy>
+void TBasicReassembly<Policy>::onPacketRecv(
+	std::span<u8> packetData, WallTimePoint rxTime, TRecvPasskey
+)
+{
+	if (packetData.empty() || packetData.size() < sizeof(Header)) {
+		tImgTransLogWarn("Received packet too small to contain valid header, ignoring.");
+		return;
+	}
+
+	auto header = Header::parse(packetData);
+	if (!header) {
+		tImgTransLogWarn("Received packet with invalid header, ignoring.");
+		return;
+	}
+
+	auto rSlot = admitPacket(header);
+	if (!rSlot) { return; }
+
+	if (rSlot->fill(packetData, header, rxTime)) {
+		pushIfComplete(rSlot);
+	} else if (header->secIdx < rSlot->expectedSecs && rSlot->hasSection(header->secIdx)) {
+		telemetry.add(TReAsmTelemetry::Counter::DUPLICATE_SECS);
 	}
 };
 
-void TReassembly::ReAsmSlotScan(TRecvPasskey)
+template<typename Policy>
+TDirectFill TBasicReassembly<Policy>::directFillTarget(
+	const Header& header, u32 payloadSize, std::span<u8>& dest, TRecvPasskey
+)
+{
+	directSlot = nullptr;
+	dest       = {};
+
+	// Admission already counted and logged whatever it refused, the copy path must not see it
+	auto rSlot = admitPacket(&header);
+	if (!rSlot) { return TDirectFill::DROP; }
+
+	// Admitting the same header again in onPacketRecv() finds this slot without side effects
+	u8* target = rSlot->fillTarget(header.secIdx, payloadSize);
+	if (!target) { return TDirectFill::COPY; }
+
+	directSlot = rSlot;
+	dest       = { target, payloadSize };
+	return TDirectFill::TARGET;
+}
+
+template<typename Policy>
+void TBasicReassembly<Policy>::commitDirectFill(
+	const Header& header, u32 payloadSize, WallTimePoint rxTime, TRecvPasskey
+)
+{
+	auto rSlot = std::exchange(directSlot, nullptr);
+
+	if (!rSlot || rSlot->frameIdx != header.frameIdx) { return; }
+
+	// Re-validate in case the slot was touched between target resolving and commit
+	if (!rSlot->fillTarget(header.secIdx, payloadSize)) { return; }
+
+	rSlot->markFilled(header.secIdx, payloadSize, rxTime);
+	pushIfComplete(rSlot);
+}
+
+template<typename Policy>
+u32 TBasicReassembly<Policy>::ReassemblingFrame::completeNalPrefix() const noexcept
+{
+	u32 firstMissing = findSection(0, false);
+	if (!frameSlot.isValid() || firstMissing == 0) { return 0; }
+
+	TAnnexBScanner scanner(
+		{ frameSlot.data(), min(firstMissing * maxPayloadSize, frameSlot.getDataLen()) }
+	);
+
+	// A NAL unit is complete once the start code of the next one has arrived
+	THevcNal nal;
+	u32      cut         = 0;
+	bool     curIsVcl    = false;
+	bool     vclComplete = false;
+
+	while (scanner.next(nal)) {
+		if (nal.start > 0) {
+			vclComplete = vclComplete || curIsVcl;
+			if (vclComplete) { cut = nal.start; }
+		}
+		curIsVcl = nal.isVcl();
+	}
+
+	return cut;
+}
+
+template<typename Policy>
+void TBasicReassembly<Policy>::logMissing([[maybe_unused]] const ReassemblingFrame& frame)
+{
+#if defined(GEN_TAU_LOG_ENABLED) && (GEN_TAU_LOG_ENABLED == 1) &&                                  \
+	(SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_DEBUG)
+	constexpr u32 maxListed = 8;
+
+	array<SectionRange, maxListed> ranges;
+
+	auto   count = frame.missingRanges(ranges);
+	string list;
+
+	for (u32 i = 0; i < min(count, maxListed); i++) {
+		const auto& range = ranges[i];
+		if (i > 0) { list += ", "; }
+		list += fmt::format("{}", range.first);
+		if (range.count > 1) { list += fmt::format("-{}", range.first + range.count - 1); }
+	}
+	if (count > maxListed) { list += ", ..."; }
+
+	tImgTransLogDebug(
+		"Frame {} timed out, {} of {} sections missing in {} runs: {}",
+		frame.frameIdx,
+		frame.missingCount(),
+		frame.expectedSecs,
+		count,
+		list
+	);
+#endif
+}
+
+template<typename Policy>
+void TBasicReassembly<Policy>::ReAsmSlotScan(TRecvPasskey)
 {
 	auto now = chrono::steady_clock::now();
 
-	if (synced.load() && now - lastSyncedTime.load() > syncTimeout) {
+	// 到达 nextScanDeadline() 的时间点即视为超时，以免定时器准时唤醒后仍然扫描不到超时的帧
+	if (synced.load() && now - lastSyncedTime.load() >= syncTimeout) {
 		tImgTransLogWarn("Sync timeout detected on reassembling frame slot scan.");
 		synced.store(false);
 	}
 
-	for (auto& frame : rFrames) {
+	auto timeout = curTimeout.load();
+
+	for (u64 mask = liveMask; mask != 0; mask &= mask - 1) {
+		auto  pos   = static_cast<u32>(countr_zero(mask));
+		auto& frame = rFrames[pos];
+
 		// 检查重组超时的帧
-		if (frame.isOccupied() && now - frame.asmStartTime > reassembleTimeout) {
+		if (now - frame.asmStartTime >= timeout) {
+			logMissing(frame);
+
+			bool pushed = false;
+
 			if (pushIncompleteAllowed() && frame.getCompleteRate() >= minFrameCompleteRate) {
 				if (Header::isAfter(frame.frameIdx, lastPushedIdx.load())) {
-					renderer->tryPushFrame(frame.steal(), {});
-					lastPushedIdx.store(frame.frameIdx);
+					u32 len = frame.frameSlot.getDataLen();
+					if (incompleteTruncated()) { len = frame.completeNalPrefix(); }
+
+					if (len > 0) {
+						auto data = frame.steal();
+						data.setDataLen(len);
+
+						pushFrame(frame.frameIdx, std::move(data), frame.rxTs, false);
+						telemetry.add(TReAsmTelemetry::Counter::PUSHED_INCOMPLETE);
+						pushed = true;
+					} else {
+						tImgTransLogDebug(
+							"Frame {} has no complete slice before its first missing section, "
+							"dropped.",
+							frame.frameIdx
+						);
+					}
 				}
 
 				// tImgTransLogTrace("Trying to push corrupted frame...");
@@ -237,9 +801,41 @@ void TReassembly::ReAsmSlotScan(TRecvPasskey)
 				// 是否比 lastPushedIdx 大即可，防止出现 push 了一个更旧的帧导致画面出现回退。
 			}
 
+			if (!pushed) { telemetry.add(TReAsmTelemetry::Counter::TIMED_OUT); }
+
 			// 无论是否推送，都清理掉这个重组槽位，防止僵尸帧过多积累导致后续帧无法重组。
-			frame.clear();
+			releaseReAsmSlot(pos);
 		}
 	}
+
+	releaseHeld(now);
 }
-}  // namespace gentau
\ No newline at end of file
+
+template<typename Policy>
+auto TBasicReassembly<Policy>::nextScanDeadline(TRecvPasskey) const noexcept -> TimePoint
+{
+	auto deadline = TimePoint::max();
+
+	if (synced.load()) { deadline = lastSyncedTime.load() + syncTimeout; }
+
+	auto timeout = curTimeout.load();
+
+	for (u64 mask = liveMask; mask != 0; mask &= mask - 1) {
+		const auto& frame = rFrames[countr_zero(mask)];
+		deadline          = min(deadline, frame.asmStartTime + timeout);
+	}
+
+	if (heldCount > 0) {
+		auto oldest = heldFrames[0].heldAt;
+		for (u32 i = 1; i < heldCount; i++) { oldest = min(oldest, heldFrames[i].heldAt); }
+
+		deadline = min(deadline, oldest + jitterDelay.load());
+	}
+
+	return deadline;
+}
+
+template class TBasicReassembly<TDefaultReAsmPolicy>;
+template class TBasicReassembly<TSmallMtuReAsmPolicy>;
+template class TBasicReassembly<TJumboReAsmPolicy>;
+}  // namespace gentau
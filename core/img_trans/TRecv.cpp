@@ -1,23 +1,298 @@
 #include "img_trans/net/TRecv.hpp"
 
+#include "img_trans/net/TUdpSock.hpp"
+#include "img_trans/net/TUring.hpp"
+
 #include "utils/TLog.hpp"
 
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#endif
+
 #include <cerrno>
+#include <cstring>
 
+#include <algorithm>
 #include <array>
+#include <bit>
 #include <chrono>
 #include <future>
+#include <mutex>
+#include <optional>
 #include <stop_token>
 #include <string_view>
 #include <system_error>
 #include <thread>
+#include <utility>
+#include <vector>
 
 #define T_LOG_TAG_IMG "[UDP Receiver] "
 
 using namespace std;
 
 namespace gentau {
-void TRecv::stop()
+namespace {
+using WallTimePoint = TVidRender::WallTimePoint;
+
+// Room for SCM_TIMESTAMPNS and SO_RXQ_OVFL, the latter is an u32 drop counter
+constexpr size_t kCtrlLen = CMSG_SPACE(sizeof(timespec)) + CMSG_SPACE(sizeof(u32));
+
+constexpr auto bufferGrowInv = 100ms;  // Drops reported right after a growth are stale
+
+template<u64 PacketLen>
+struct [[gnu::aligned(64)]] RecvBuf
+{
+	array<u8, PacketLen> packet;
+
+	alignas(cmsghdr) array<u8, kCtrlLen> ctrl;  // Ancillary data, i.e. the kernel timestamp
+
+	auto data() { return packet.data(); }
+
+	RecvBuf()
+	{
+		memset(packet.data(), 0, PacketLen);
+		memset(ctrl.data(), 0, kCtrlLen);
+	}
+};
+
+struct ScopedFd
+{
+	int fd = -1;
+
+	explicit ScopedFd(int _fd) : fd(_fd) {}
+	~ScopedFd()
+	{
+		if (fd > -1) { ::close(fd); }
+	}
+
+	ScopedFd(const ScopedFd&)            = delete;
+	ScopedFd& operator=(const ScopedFd&) = delete;
+};
+
+constexpr i32 ENOMEM_THRES = 5;
+
+#ifdef __linux__
+constexpr i32 kRecvFlags   = MSG_DONTWAIT;  // The socket is drained after epoll reports it readable
+constexpr u32 kDrainBudget = 64;  // Receive calls per wake up, so a busy link can not starve scans
+#else
+constexpr i32 kRecvFlags   = 0;  // Blocking receive, bounded by SO_RCVTIMEO
+constexpr u32 kDrainBudget = 1;
+#endif
+
+using TimePoint = chrono::steady_clock::time_point;
+
+enum class DrainStep : u8
+{
+	MORE = 0,  // Something was received, the socket may hold more
+	DRAINED,   // Nothing left to receive for now
+	FATAL      // Unrecoverable error, stop the receiving thread
+};
+
+bool isWouldBlock(i32 err)
+{
+	return err == EAGAIN || err == EWOULDBLOCK;
+}
+
+[[maybe_unused]] std::string_view backendName(TRecvBackend backend)
+{
+	switch (backend) {
+		case TRecvBackend::CLASSIC:
+			return "CLASSIC";
+		case TRecvBackend::BATCHED:
+			return "BATCHED";
+		case TRecvBackend::ZERO_COPY:
+			return "ZERO_COPY";
+		case TRecvBackend::IO_URING:
+			return "IO_URING";
+		default:
+			return "UNDEFINED";
+	}
+}
+
+#ifdef __linux__
+/**
+ * One-shot timer that fires at the next reassembly deadline (CLOCK_MONOTONIC, which backs
+ * std::chrono::steady_clock). It is only ever moved earlier by arm(); a deadline that moved
+ * later just costs one early scan, after which the timer is re-armed.
+ */
+class ScanTimer
+{
+  private:
+	ScopedFd  timerFd{ -1 };
+	TimePoint armed = TimePoint::max();
+
+  public:
+	i32 init()
+	{
+		timerFd.fd = ::timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+		return timerFd.fd < 0 ? errno : 0;
+	}
+
+	int fd() const noexcept { return timerFd.fd; }
+
+	void arm(TimePoint deadline) noexcept
+	{
+		if (deadline >= armed) { return; }
+
+		auto ns = chrono::duration_cast<chrono::nanoseconds>(deadline.time_since_epoch()).count();
+		ns      = max<i64>(ns, 1);  // A zero it_value would disarm the timer instead
+
+		itimerspec spec{};
+		spec.it_value.tv_sec  = ns / 1'000'000'000;
+		spec.it_value.tv_nsec = ns % 1'000'000'000;
+
+		if (::timerfd_settime(timerFd.fd, TFD_TIMER_ABSTIME, &spec, nullptr) == 0) {
+			armed = deadline;
+		}
+	}
+
+	// Must be called once the expiration has been read from fd(), the timer is disarmed then.
+	void expired() noexcept { armed = TimePoint::max(); }
+};
+
+/**
+ * eventfd that becomes readable once a stop is requested on the receiving thread. Both fds are
+ * left blocking, io_uring would otherwise complete reads on them with -EAGAIN.
+ */
+class StopEvent
+{
+  private:
+	struct Waker
+	{
+		int fd = -1;
+
+		void operator()() const noexcept
+		{
+			u64 one = 1;
+			[[maybe_unused]] auto ret = ::write(fd, &one, sizeof(one));
+		}
+	};
+
+	ScopedFd                             eventFd{ -1 };
+	optional<stop_callback<Waker>> onStop;
+
+  public:
+	i32 init(stop_token sToken)
+	{
+		eventFd.fd = ::eventfd(0, EFD_CLOEXEC);
+		if (eventFd.fd < 0) { return errno; }
+
+		onStop.emplace(std::move(sToken), Waker{ eventFd.fd });
+		return 0;
+	}
+
+	int fd() const noexcept { return eventFd.fd; }
+};
+
+/**
+ * Puts the receiving thread to sleep until the socket is readable, the scan timer expired or
+ * a stop was requested, so an idle link causes no wake up at all.
+ */
+class RecvEvents
+{
+  public:
+	enum : u32
+	{
+		READABLE = 1u << 0,
+		SCAN_DUE = 1u << 1,
+		STOP     = 1u << 2,
+	};
+
+  private:
+	ScopedFd  epollFd{ -1 };
+	ScanTimer timer;
+	StopEvent stop;
+
+  public:
+	i32 init(int sock, stop_token sToken)
+	{
+		if (auto err = timer.init(); err != 0) { return err; }
+		if (auto err = stop.init(std::move(sToken)); err != 0) { return err; }
+
+		epollFd.fd = ::epoll_create1(EPOLL_CLOEXEC);
+		if (epollFd.fd < 0) { return errno; }
+
+		for (auto [fd, tag] : { pair{ sock, READABLE },
+								pair{ timer.fd(), SCAN_DUE },
+								pair{ stop.fd(), STOP } }) {
+			epoll_event ev{};
+			ev.events   = EPOLLIN;
+			ev.data.u32 = tag;
+			if (::epoll_ctl(epollFd.fd, EPOLL_CTL_ADD, fd, &ev) < 0) { return errno; }
+		}
+
+		return 0;
+	}
+
+	u32 wait() noexcept
+	{
+		array<epoll_event, 3> evs;
+
+		auto n = ::epoll_wait(epollFd.fd, evs.data(), static_cast<int>(evs.size()), -1);
+		if (n < 0) { return 0; }  // EINTR, the caller just waits again
+
+		u32 flags = 0;
+		for (int i = 0; i < n; i++) { flags |= evs[i].data.u32; }
+
+		if (flags & SCAN_DUE) {
+			u64 expirations = 0;  // Readable, so this does not block
+			[[maybe_unused]] auto ret = ::read(timer.fd(), &expirations, sizeof(expirations));
+			timer.expired();
+		}
+
+		return flags;
+	}
+
+	void armScan(TimePoint deadline) noexcept { timer.arm(deadline); }
+};
+#else
+/**
+ * Fallback for platforms without epoll / timerfd / eventfd: the blocking receive wakes up at
+ * least every SO_RCVTIMEO, and the scan deadline is checked on each wake up.
+ */
+class RecvEvents
+{
+  public:
+	enum : u32
+	{
+		READABLE = 1u << 0,
+		SCAN_DUE = 1u << 1,
+		STOP     = 1u << 2,
+	};
+
+  private:
+	stop_token token;
+	TimePoint  armed = TimePoint::max();
+
+  public:
+	i32 init(int, stop_token sToken)
+	{
+		token = std::move(sToken);
+		return 0;
+	}
+
+	u32 wait() noexcept
+	{
+		if (token.stop_requested()) { return STOP; }
+
+		u32 flags = READABLE;
+		if (chrono::steady_clock::now() >= armed) {
+			flags |= SCAN_DUE;
+			armed  = TimePoint::max();
+		}
+
+		return flags;
+	}
+
+	void armScan(TimePoint deadline) noexcept { armed = min(armed, deadline); }
+};
+#endif
+}  // namespace
+
+template<typename Policy>
+void TBasicRecv<Policy>::stop()
 {
 	if (recvThread.joinable()) {
 		recvThread.request_stop();
@@ -25,12 +300,729 @@ void TRecv::stop()
 	}
 }
 
-void TRecv::stopAsync()
+template<typename Policy>
+void TBasicRecv<Policy>::stopAsync()
 {
 	recvThread.request_stop();
 }
 
-int TRecv::start()
+template<typename Policy>
+WallTimePoint TBasicRecv<Policy>::handleCtrlMsg(msghdr& msg) noexcept
+{
+	WallTimePoint rxTime{};
+
+	for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+		if (cmsg->cmsg_level != SOL_SOCKET) { continue; }
+
+#ifdef SO_TIMESTAMPNS
+		if (cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+			timespec ts;
+			memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+
+			rxTime = WallTimePoint(chrono::duration_cast<WallTimePoint::duration>(
+				chrono::seconds(ts.tv_sec) + chrono::nanoseconds(ts.tv_nsec)
+			));
+		}
+#endif
+
+#ifdef SO_RXQ_OVFL
+		if (cmsg->cmsg_type == SO_RXQ_OVFL) {
+			u32 counter;
+			memcpy(&counter, CMSG_DATA(cmsg), sizeof(counter));
+
+			u32 dropped     = counter - lastDropCounter;  // Unsigned, survives the wrap around
+			lastDropCounter = counter;
+
+			if (dropped > 0) {
+				kernelDrops.fetch_add(dropped, memory_order_relaxed);
+				tImgTransLogTrace("Kernel dropped {} datagrams on the receive queue", dropped);
+
+				growRecvBuffer();
+			}
+		}
+#endif
+	}
+
+	return rxTime;
+}
+
+template<typename Policy>
+void TBasicRecv<Policy>::recordPacket(
+	std::span<const u8> head, std::span<const u8> payload, WallTimePoint rxTime
+)
+{
+	if (!capturing.load(memory_order_relaxed)) [[likely]] { return; }
+
+	lock_guard lock(captureMutex);
+	if (!recorder) { return; }
+
+	if (recorder->append(head, payload, rxTime, chrono::steady_clock::now()) != 0) {
+		// The recorder logged the reason, keep the records written so far
+		recorder.reset();
+		capturing.store(false);
+	}
+}
+
+template<typename Policy>
+i32 TBasicRecv<Policy>::startCapture(const std::string& path)
+{
+	lock_guard lock(captureMutex);
+
+	recorder.reset();  // Close the running capture before its file might get reused
+	capturing.store(false);
+
+	auto newRecorder = TCaptureRecorder::create(path);
+	if (!newRecorder->isOpen()) { return newRecorder->getError(); }
+
+	recorder = std::move(newRecorder);
+	capturing.store(true);
+
+	return 0;
+}
+
+template<typename Policy>
+u64 TBasicRecv<Policy>::stopCapture()
+{
+	lock_guard lock(captureMutex);
+
+	capturing.store(false);
+	if (!recorder) { return 0; }
+
+	auto records = recorder->getRecordCount();
+	recorder.reset();
+
+	return records;
+}
+
+template<typename Policy>
+void TBasicRecv<Policy>::impairPacket(std::span<u8> packet, WallTimePoint rxTime)
+{
+	auto now = chrono::steady_clock::now();
+
+	releaseImpaired(now);  // Held datagrams that are due were received before this one
+
+	if (impairment->submit(packet, rxTime, now) == TImpairment::Verdict::PASS) {
+		reassembler->onPacketRecv(packet, rxTime, {});
+	}
+}
+
+template<typename Policy>
+void TBasicRecv<Policy>::releaseImpaired(TimePoint now)
+{
+	TPacket held;
+	while (impairment->popDue(now, held)) {
+		reassembler->onPacketRecv(held.data, held.rxTime, {});
+	}
+}
+
+template<typename Policy>
+void TBasicRecv<Policy>::onTimerDue()
+{
+	if (impairment) { releaseImpaired(chrono::steady_clock::now()); }
+
+	reassembler->ReAsmSlotScan({});
+}
+
+template<typename Policy>
+TimePoint TBasicRecv<Policy>::nextTimerDeadline() const noexcept
+{
+	auto deadline = reassembler->nextScanDeadline({});
+	if (impairment) { deadline = min(deadline, impairment->nextRelease()); }
+
+	return deadline;
+}
+
+template<typename Policy>
+void TBasicRecv<Policy>::growRecvBuffer() noexcept
+{
+	auto cur = recvBufferSize.load();
+	if (bufferCapped || options.recvBufferMax <= cur) { return; }
+
+	auto now = chrono::steady_clock::now();
+	if (now < lastBufferGrow + bufferGrowInv) { return; }  // No `now - min()`, it overflows
+	lastBufferGrow = now;
+
+	auto next = static_cast<i32>(min<i64>(static_cast<i64>(cur) * 2, options.recvBufferMax));
+
+	if (auto err = TUdpSock::setRecvBuffer(updSock, next); err != 0) {
+		tImgTransLogWarn(
+			"Failed to grow socket receive buffer to {} bytes, error: {}",
+			next,
+			error_code(err, system_category()).message()
+		);
+		bufferCapped = true;
+		return;
+	}
+
+	// Without CAP_NET_ADMIN, SO_RCVBUF is silently clamped to net.core.rmem_max
+	auto actual = TUdpSock::getRecvBuffer(updSock);
+	if (actual.has_value() && actual.value() < next) {
+		tImgTransLogWarn(
+			"Socket receive buffer clamped to {} bytes instead of {}, raise "
+			"net.core.rmem_max to allow further growth.",
+			actual.value(),
+			next
+		);
+		recvBufferSize.store(actual.value());
+		bufferCapped = true;
+		return;
+	}
+
+	recvBufferSize.store(next);
+	if (next >= options.recvBufferMax) { bufferCapped = true; }
+
+	tImgTransLogInfo(
+		"Kernel dropped datagrams ({} so far), socket receive buffer grown from {} to {} bytes",
+		kernelDrops.load(memory_order_relaxed),
+		cur,
+		next
+	);
+}
+
+template<typename Policy>
+bool TBasicRecv<Policy>::handleRecvError(i32 err, i32& enomemCount)
+{
+	if (err == EAGAIN || err == EWOULDBLOCK) {
+		return true;  // Timeout, just try again
+	}
+
+	if (err == ENOMEM) {
+		enomemCount++;
+		tImgTransLogWarn(
+			"Receive failed with ENOMEM (kernel socket buffer out of memory), "
+			"consecutive count: {}.",
+			enomemCount
+		);
+
+		if (enomemCount > ENOMEM_THRES) {
+			onRecvError(err);
+			tImgTransLogError(
+				"Receive failed with ENOMEM {} times in a row. Stopping recieve "
+				"thread.",
+				enomemCount
+			);
+			return false;
+		}
+
+		this_thread::sleep_for(chrono::milliseconds(enomemCount));
+		return true;
+	}
+
+	if (err == EINTR) {
+		tImgTransLogWarn("Recieve interrupted by a system signal");
+		return true;  // Interrupted by signal, just try again
+	}
+
+	if (err == ECONNREFUSED || err == ENOTCONN) [[unlikely]] {
+		tImgTransLogWarn(
+			"Recieve failed with error: {}, ignoring this",
+			error_code(err, system_category()).message()
+		);
+		return true;  // These errors should not happen as there is no connection and send at all
+	}
+
+	tImgTransLogError(
+		"Receive failed with error: {}. Stopping receive thread.",
+		error_code(err, system_category()).message()
+	);
+	onRecvError(err);
+	return false;
+}
+
+template<typename Policy>
+template<typename RecvFn>
+void TBasicRecv<Policy>::runRecvLoop(stop_token sToken, RecvFn&& recvOnce)
+{
+	RecvEvents events;
+	if (auto err = events.init(updSock, sToken); err != 0) {
+		tImgTransLogError(
+			"Failed to set up receive event loop, error: {}. Stopping receive thread.",
+			error_code(err, system_category()).message()
+		);
+		onRecvError(err);
+		return;
+	}
+
+	while (!sToken.stop_requested()) {
+		auto flags = events.wait();
+		if (flags & RecvEvents::STOP) { break; }
+
+		if (flags & RecvEvents::SCAN_DUE) { onTimerDue(); }
+
+		if (flags & RecvEvents::READABLE) {
+			for (u32 i = 0; i < kDrainBudget; i++) {
+				auto step = recvOnce();
+				if (step == DrainStep::FATAL) { return; }
+				if (step == DrainStep::DRAINED) { break; }
+			}
+		}
+
+		// New frames may have started, the earliest deadline can only have moved forward here
+		events.armScan(nextTimerDeadline());
+	}
+}
+
+template<typename Policy>
+void TBasicRecv<Policy>::recvLoopClassic(stop_token sToken)
+{
+	RecvBuf<mtuLen> recvBuffer;
+
+	iovec iov{ .iov_base = recvBuffer.data(), .iov_len = mtuLen };
+
+	msghdr msg     = {};
+	msg.msg_iov    = &iov;
+	msg.msg_iovlen = 1;
+
+	i32 ENOMEM_count = 0;
+
+	runRecvLoop(sToken, [&]() {
+		msg.msg_control    = recvBuffer.ctrl.data();
+		msg.msg_controllen = kCtrlLen;  // Overwritten by the kernel on every call
+
+		auto ret = ::recvmsg(updSock, &msg, kRecvFlags);
+
+		if (ret > 0) {
+			ENOMEM_count = 0;  // Reset ENOMEM counter on successful receive
+
+			lastRecvTime.store(chrono::steady_clock::now());
+			recvCalls.fetch_add(1, memory_order_relaxed);
+			recvDatagrams.fetch_add(1, memory_order_relaxed);
+
+			dispatchPacket(std::span(recvBuffer.packet).subspan(0, ret), handleCtrlMsg(msg));
+			return DrainStep::MORE;
+		} else if (ret == 0) [[unlikely]] {
+			ENOMEM_count = 0;  // ret == 0 indicates zero-length packet in UDP (DGRAM sock)
+
+			return DrainStep::MORE;
+		}
+
+		auto err = errno;
+		if (isWouldBlock(err)) { return DrainStep::DRAINED; }
+		return handleRecvError(err, ENOMEM_count) ? DrainStep::MORE : DrainStep::FATAL;
+	});
+}
+
+#ifdef __linux__
+template<typename Policy>
+void TBasicRecv<Policy>::recvLoopBatched(stop_token sToken)
+{
+	const u32 batchSize = clamp<u32>(options.batchSize, 1, maxBatchSize);
+
+	// Ring of cache-line aligned packet buffers, one per datagram slot of recvmmsg()
+	vector<RecvBuf<mtuLen>> bufRing(batchSize);
+	vector<iovec>   iovs(batchSize);
+	vector<mmsghdr> msgs(batchSize);
+
+	for (u32 i = 0; i < batchSize; i++) {
+		iovs[i].iov_base = bufRing[i].data();
+		iovs[i].iov_len  = mtuLen;
+
+		msgs[i]                     = {};
+		msgs[i].msg_hdr.msg_iov     = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen  = 1;
+		msgs[i].msg_hdr.msg_control = bufRing[i].ctrl.data();
+	}
+
+	tImgTransLogDebug("Batched receive loop started, batch size: {}", batchSize);
+
+	i32 ENOMEM_count = 0;
+
+	u32 usedSlots = batchSize;  // Slots written by the previous call, whose msg_controllen changed
+
+	runRecvLoop(sToken, [&]() {
+		for (u32 i = 0; i < usedSlots; i++) { msgs[i].msg_hdr.msg_controllen = kCtrlLen; }
+
+		// Take whatever is already queued, up to batchSize datagrams, without blocking
+		auto ret = ::recvmmsg(updSock, msgs.data(), batchSize, kRecvFlags, nullptr);
+
+		if (ret > 0) {
+			ENOMEM_count = 0;
+			usedSlots    = static_cast<u32>(ret);
+
+			lastRecvTime.store(chrono::steady_clock::now());
+			recvCalls.fetch_add(1, memory_order_relaxed);
+			recvDatagrams.fetch_add(static_cast<u64>(ret), memory_order_relaxed);
+
+			for (i32 i = 0; i < ret; i++) {
+				auto len = msgs[i].msg_len;
+				if (len == 0) [[unlikely]] { continue; }
+
+				dispatchPacket(
+					std::span(bufRing[i].packet).subspan(0, len), handleCtrlMsg(msgs[i].msg_hdr)
+				);
+			}
+
+			// A partial batch means the socket queue is empty now, skip the EAGAIN round trip
+			return static_cast<u32>(ret) < batchSize ? DrainStep::DRAINED : DrainStep::MORE;
+		} else if (ret == 0) [[unlikely]] {
+			ENOMEM_count = 0;
+
+			return DrainStep::MORE;
+		}
+
+		auto err = errno;
+		if (isWouldBlock(err)) { return DrainStep::DRAINED; }
+		return handleRecvError(err, ENOMEM_count) ? DrainStep::MORE : DrainStep::FATAL;
+	});
+
+	[[maybe_unused]] auto stats = getRecvStats();
+	tImgTransLogDebug(
+		"Batched receive loop stopped, {} datagrams in {} syscalls (avg batch fill {:.2f}/{})",
+		stats.datagrams,
+		stats.recvCalls,
+		stats.avgBatchFill(),
+		batchSize
+	);
+}
+
+template<typename Policy>
+void TBasicRecv<Policy>::recvLoopZeroCopy(stop_token sToken)
+{
+	using Header = TPacketHeader;
+
+	RecvBuf<mtuLen> fallbackBuffer;  // Copy path for duplicated or odd sized sections
+	Header  peekHeader{};
+	Header  recvHeader{};
+
+	i32 ENOMEM_count = 0;
+
+	runRecvLoop(sToken, [&]() {
+		// MSG_TRUNC makes the kernel report the real datagram length instead of the peeked one
+		auto peekRet =
+			::recv(updSock, &peekHeader, sizeof(Header), MSG_PEEK | MSG_TRUNC | kRecvFlags);
+
+		if (peekRet < 0) {
+			auto err = errno;
+			if (isWouldBlock(err)) { return DrainStep::DRAINED; }
+			return handleRecvError(err, ENOMEM_count) ? DrainStep::MORE : DrainStep::FATAL;
+		}
+
+		ENOMEM_count = 0;
+
+		// The impairment stage needs its own copy of the datagram, take the copy path then
+		std::span<u8> dest;
+		auto          verdict = TDirectFill::COPY;
+		if (!impairment && peekRet > static_cast<ssize_t>(sizeof(Header)) &&
+			peekRet <= static_cast<ssize_t>(mtuLen)) {
+			verdict = reassembler->directFillTarget(
+				peekHeader, static_cast<u32>(peekRet - sizeof(Header)), dest, {}
+			);
+		}
+
+		iovec iovs[2];
+		if (verdict == TDirectFill::TARGET) {
+			iovs[0].iov_base = &recvHeader;
+			iovs[0].iov_len  = sizeof(Header);
+			iovs[1].iov_base = dest.data();
+			iovs[1].iov_len  = dest.size();
+		} else {
+			iovs[0].iov_base = fallbackBuffer.data();
+			iovs[0].iov_len  = mtuLen;
+		}
+
+		msghdr msg         = {};
+		msg.msg_iov        = iovs;
+		msg.msg_iovlen     = verdict == TDirectFill::TARGET ? 2 : 1;
+		msg.msg_control    = fallbackBuffer.ctrl.data();
+		msg.msg_controllen = kCtrlLen;
+
+		auto ret = ::recvmsg(updSock, &msg, kRecvFlags);
+
+		if (ret > 0 && verdict == TDirectFill::TARGET) {
+			auto rxTime = handleCtrlMsg(msg);
+
+			if (ret == peekRet && memcmp(&recvHeader, &peekHeader, sizeof(Header)) == 0) {
+				auto headBytes = reinterpret_cast<const u8*>(&recvHeader);
+
+				recordPacket(std::span(headBytes, sizeof(Header)), dest, rxTime);
+				reassembler->commitDirectFill(
+					recvHeader, static_cast<u32>(dest.size()), rxTime, {}
+				);
+				directFills.fetch_add(1, memory_order_relaxed);
+			} else [[unlikely]] {
+				tImgTransLogWarn("Datagram changed between peek and receive, dropping it.");
+			}
+		} else if (ret > 0) {
+			auto packet = std::span(fallbackBuffer.packet).subspan(0, ret);
+			auto rxTime = handleCtrlMsg(msg);
+
+			// A datagram refused by admission is only consumed, admitting it again would count
+			// it twice. It still goes into the capture, which holds what came off the wire.
+			if (verdict == TDirectFill::COPY) {
+				dispatchPacket(packet, rxTime);
+			} else {
+				recordPacket(packet, {}, rxTime);
+			}
+		}
+
+		if (ret > 0) {
+			lastRecvTime.store(chrono::steady_clock::now());
+			recvCalls.fetch_add(2, memory_order_relaxed);  // The peek counts as a syscall too
+			recvDatagrams.fetch_add(1, memory_order_relaxed);
+		} else if (ret < 0) {
+			auto err = errno;
+			if (isWouldBlock(err)) { return DrainStep::DRAINED; }
+			if (!handleRecvError(err, ENOMEM_count)) { return DrainStep::FATAL; }
+		}
+
+		return DrainStep::MORE;
+	});
+}
+
+template<typename Policy>
+bool TBasicRecv<Policy>::recvLoopUring(stop_token sToken)
+{
+	constexpr u16 kBufGroup   = 0;
+	constexpr u64 kRecvTag    = 1;
+	constexpr u64 kTimerTag   = 2;
+	constexpr u64 kStopTag    = 3;
+	constexpr u64 kCancelTag  = 4;
+
+	if (!TUring::isSupported()) { return false; }
+
+	TUring ring;
+	if (auto err = ring.init(16); err != 0) {
+		tImgTransLogWarn(
+			"Failed to create io_uring: {}", error_code(err, system_category()).message()
+		);
+		return false;
+	}
+
+	const u32 bufCount = bit_ceil(clamp<u32>(options.uringBufCount, 1, maxUringBufCount));
+	const u32 bufLen   = (sizeof(io_uring_recvmsg_out) + kCtrlLen + mtuLen + 63) & ~63u;
+
+	if (auto err = ring.setupBufRing(kBufGroup, bufCount, bufLen); err != 0) {
+		tImgTransLogWarn(
+			"Failed to register io_uring buffer ring: {}",
+			error_code(err, system_category()).message()
+		);
+		return false;
+	}
+
+	// Stop requests and scan deadlines wake the ring through reads on these fds
+	ScanTimer timer;
+	StopEvent stop;
+	for (auto err : { timer.init(), stop.init(sToken) }) {
+		if (err != 0) {
+			tImgTransLogWarn(
+				"Failed to create io_uring wake up fds: {}",
+				error_code(err, system_category()).message()
+			);
+			return false;
+		}
+	}
+
+	msghdr recvTmpl{};  // No name, only the kernel timestamp as control data and the payload
+	recvTmpl.msg_controllen = kCtrlLen;
+	u64    stopVal  = 0;
+	u64    timerVal = 0;
+
+	// The SQ only fills up with unsubmitted entries, so flush them once before giving up
+	auto nextSqe = [&]() {
+		auto sqe = ring.getSqe();
+		if (!sqe && ring.submit() == 0) { sqe = ring.getSqe(); }
+		return sqe;
+	};
+
+	auto armRecv = [&]() {
+		auto sqe = nextSqe();
+		if (!sqe) { return false; }
+
+		sqe->opcode    = IORING_OP_RECVMSG;
+		sqe->fd        = updSock;
+		sqe->addr      = reinterpret_cast<u64>(&recvTmpl);
+		sqe->len       = 1;
+		sqe->flags     = IOSQE_BUFFER_SELECT;
+		sqe->buf_group = kBufGroup;
+		sqe->ioprio    = IORING_RECV_MULTISHOT;
+		sqe->user_data = kRecvTag;
+		return true;
+	};
+
+	auto armRead = [&](int fd, u64* val, u64 tag) {
+		auto sqe = nextSqe();
+		if (!sqe) { return false; }
+
+		sqe->opcode    = IORING_OP_READ;
+		sqe->fd        = fd;
+		sqe->addr      = reinterpret_cast<u64>(val);
+		sqe->len       = sizeof(u64);
+		sqe->user_data = tag;
+		return true;
+	};
+
+	auto cancel = [&](u64 tag) {
+		auto sqe = nextSqe();
+		if (!sqe) { return false; }
+
+		sqe->opcode    = IORING_OP_ASYNC_CANCEL;
+		sqe->addr      = tag;
+		sqe->user_data = kCancelTag;
+		return true;
+	};
+
+	if (!armRead(stop.fd(), &stopVal, kStopTag) || !armRead(timer.fd(), &timerVal, kTimerTag) ||
+		!armRecv()) {
+		tImgTransLogWarn("Failed to queue the initial io_uring requests");
+		return false;
+	}
+
+	bool recvArmed   = true;
+	bool timerArmed  = true;
+	bool stopArmed   = true;
+	bool running     = true;
+	bool unsupported = false;
+	u64  delivered   = 0;
+
+	i32 ENOMEM_count = 0;
+
+	tImgTransLogDebug("io_uring receive loop started, {} buffers of {} bytes", bufCount, bufLen);
+
+	while (running && !sToken.stop_requested()) {
+		if (auto err = ring.submit(1); err != 0) {
+			if (err == EINTR || err == EAGAIN || err == EBUSY) { continue; }
+
+			tImgTransLogError(
+				"io_uring_enter failed: {}. Stopping receive thread.",
+				error_code(err, system_category()).message()
+			);
+			onRecvError(err);
+			break;
+		}
+
+		u64  batch     = 0;
+		bool rearmRecv = false;
+		bool scanDue   = false;
+
+		ring.drainCompletions([&](const TUring::Completion& cqe) {
+			switch (cqe.userData) {
+				case kRecvTag: {
+					if (!(cqe.flags & IORING_CQE_F_MORE)) {
+						recvArmed = false;
+						rearmRecv = true;
+					}
+
+					if (cqe.res < 0) {
+						if (cqe.res == -ENOBUFS) { return; }  // Re-armed after recycling
+
+						if (cqe.res == -EINVAL && delivered == 0) {
+							unsupported = true;  // Multishot recvmsg needs Linux 6.0+
+							running     = false;
+							return;
+						}
+
+						if (!handleRecvError(-cqe.res, ENOMEM_count)) { running = false; }
+						return;
+					}
+
+					if (!(cqe.flags & IORING_CQE_F_BUFFER)) [[unlikely]] { return; }
+
+					auto bid = static_cast<u16>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+					auto buf = ring.buffer(bid);
+
+					if (static_cast<size_t>(cqe.res) >= sizeof(io_uring_recvmsg_out)) {
+						auto out     = reinterpret_cast<const io_uring_recvmsg_out*>(buf.data());
+						auto offset  = sizeof(io_uring_recvmsg_out) + recvTmpl.msg_namelen +
+									  recvTmpl.msg_controllen;
+						auto payload = min<size_t>(out->payloadlen, buf.size() - offset);
+
+						// The control data follows the header (and the empty name) in the buffer
+						msghdr ctrlView         = {};
+						ctrlView.msg_control    = buf.data() + sizeof(io_uring_recvmsg_out);
+						ctrlView.msg_controllen = out->controllen;
+
+						if (payload > 0) {
+							ENOMEM_count = 0;
+							dispatchPacket(buf.subspan(offset, payload), handleCtrlMsg(ctrlView));
+							batch++;
+						}
+					}
+
+					ring.recycleBuffer(bid);
+					break;
+				}
+				case kTimerTag: {
+					timer.expired();
+					timerArmed = false;
+					scanDue    = true;
+					break;
+				}
+				case kStopTag: {
+					stopArmed = false;
+					running   = false;
+					break;
+				}
+				default:
+					break;  // Cancel completions
+			}
+		});
+
+		ring.publishBuffers();
+
+		if (batch > 0) {
+			delivered += batch;
+			lastRecvTime.store(chrono::steady_clock::now());
+			recvCalls.fetch_add(1, memory_order_relaxed);
+			recvDatagrams.fetch_add(batch, memory_order_relaxed);
+		}
+
+		if (scanDue) { onTimerDue(); }
+
+		if (!running) { break; }
+
+		if (rearmRecv) { recvArmed = armRecv(); }
+		if (!timerArmed) { timerArmed = armRead(timer.fd(), &timerVal, kTimerTag); }
+
+		if ((rearmRecv && !recvArmed) || !timerArmed) {
+			tImgTransLogError("Failed to re-arm io_uring requests. Stopping receive thread.");
+			onRecvError(EBUSY);
+			break;
+		}
+
+		timer.arm(nextTimerDeadline());
+	}
+
+	// Cancel everything still in flight and wait for the kernel to let go of our buffers
+	// A request whose cancel can not be queued is left to the ring teardown
+	bool cancelled = true;
+	if (recvArmed) { cancelled &= cancel(kRecvTag); }
+	if (timerArmed) { cancelled &= cancel(kTimerTag); }
+	if (stopArmed) { cancelled &= cancel(kStopTag); }
+
+	while (cancelled && (recvArmed || timerArmed || stopArmed)) {
+		if (auto err = ring.submit(1); err != 0 && err != EINTR) { break; }
+
+		ring.drainCompletions([&](const TUring::Completion& cqe) {
+			switch (cqe.userData) {
+				case kRecvTag:
+					if (cqe.flags & IORING_CQE_F_BUFFER) {
+						ring.recycleBuffer(static_cast<u16>(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+					}
+					if (!(cqe.flags & IORING_CQE_F_MORE)) { recvArmed = false; }
+					break;
+				case kTimerTag:
+					timerArmed = false;
+					break;
+				case kStopTag:
+					stopArmed = false;
+					break;
+				default:
+					break;
+			}
+		});
+	}
+
+	if (unsupported) {
+		tImgTransLogWarn("Multishot recvmsg is not supported by this kernel (needs Linux 6.0+)");
+		return false;
+	}
+
+	return true;
+}
+#endif  // __linux__
+
+template<typename Policy>
+int TBasicRecv<Policy>::start()
 {
 	if (!isBound()) {
 		tImgTransLogError("Cannot start receiving thread: socket is not bound");
@@ -47,107 +1039,92 @@ int TRecv::start()
 
 	recvThread = jthread([this,
 						  passThru = std::move(threadErrPassThru)](stop_token sToken) mutable {
-		if (::setsockopt(updSock, SOL_SOCKET, SO_RCVBUF, &kRecvBufferSize, sizeof(i32)) < 0) {
+		if (!options.threadPolicy.isDefault()) {
+			[[maybe_unused]] auto applied = options.threadPolicy.apply("gt-udp-recv");
+			tImgTransLogInfo("Receiving thread policy applied: {}", applied.toString());
+		}
+
+		if (auto err = TUdpSock::setRecvBuffer(updSock, options.recvBufferSize); err != 0) {
 			tImgTransLogError(
 				"Failed to set socket kernel receive buffer size, error: {}",
-				error_code(errno, system_category()).message()
+				error_code(err, system_category()).message()
 			);
-			passThru.set_value(errno);
+			passThru.set_value(err);
 			return;
 		}
 
-		if (::setsockopt(updSock, SOL_SOCKET, SO_RCVTIMEO, &kRecvTimeout, sizeof(timeval)) < 0) {
+		// Without CAP_NET_ADMIN, SO_RCVBUF is silently clamped to net.core.rmem_max
+		auto granted = TUdpSock::getRecvBuffer(updSock).value_or(options.recvBufferSize);
+		recvBufferSize.store(granted);
+		bufferCapped = granted < options.recvBufferSize;
+		if (bufferCapped) {
+			tImgTransLogWarn(
+				"Socket receive buffer clamped to {} bytes instead of {}, raise "
+				"net.core.rmem_max to allow a larger buffer.",
+				granted,
+				options.recvBufferSize
+			);
+		}
+
+		if (auto err = TUdpSock::setRecvTimeout(updSock, kRecvTimeout); err != 0) {
 			tImgTransLogError(
 				"Failed to set socket receive timeout, error: {}",
-				error_code(errno, system_category()).message()
+				error_code(err, system_category()).message()
 			);
-			passThru.set_value(errno);
+			passThru.set_value(err);
 			return;
 		}
 
-		passThru.set_value(0);
-
-		struct [[gnu::aligned(64)]] RecvBuf
-		{
-			array<u8, MTU_LEN> packet;
-
-			auto data() { return packet.data(); }
-
-			RecvBuf() { memset(packet.data(), 0, MTU_LEN); }
-		} recvBuffer;
-
-		i32           ENOMEM_count = 0;
-		constexpr i32 ENOMEM_THRES = 5;
-
-		auto           lastReAsmScanTime = chrono::steady_clock::now();
-		constexpr auto reAsmScanInv      = 5ms;
-
-		while (!sToken.stop_requested()) {
-			auto now = chrono::steady_clock::now();
-			if (now - lastReAsmScanTime > reAsmScanInv) {
-				reassembler->ReAsmSlotScan({});
-				lastReAsmScanTime = now;
+		// Both are Linux only, ENOTSUP elsewhere is expected and not worth a warning
+		if (options.kernelTimestamps) {
+			if (auto err = TUdpSock::enableTimestamps(updSock); err != 0 && err != ENOTSUP) {
+				tImgTransLogWarn(
+					"Kernel receive timestamps unavailable, error: {}",
+					error_code(err, system_category()).message()
+				);
 			}
+		}
 
-			auto ret = ::recv(updSock, recvBuffer.data(), MTU_LEN, 0);
-
-			if (ret > 0) {
-				ENOMEM_count = 0;  // Reset ENOMEM counter on successful receive
-
-				lastRecvTime.store(chrono::steady_clock::now());
-
-				reassembler->onPacketRecv(std::span(recvBuffer.packet).subspan(0, ret), {});
-			} else if (ret == 0) [[unlikely]] {
-				ENOMEM_count = 0;  // ret == 0 indicates zero-length packet in UDP (DGRAM sock)
-
-				continue;
-			} else {
-				if (errno == EAGAIN || errno == EWOULDBLOCK) {
-					continue;  // Timeout, just try again
-				}
-
-				if (errno == ENOMEM) {
-					ENOMEM_count++;
-					tImgTransLogWarn(
-						"Receive failed with ENOMEM (kernel socket buffer out of memory), "
-						"consecutive count: {}.",
-						ENOMEM_count
-					);
-
-					if (ENOMEM_count > ENOMEM_THRES) {
-						onRecvError(errno);
-						tImgTransLogError(
-							"Receive failed with ENOMEM {} times in a row. Stopping recieve "
-							"thread.",
-							ENOMEM_count
-						);
-						break;
-					}
+		if (auto err = TUdpSock::enableDropCounter(updSock); err != 0 && err != ENOTSUP) {
+			tImgTransLogWarn(
+				"Kernel drop accounting unavailable, error: {}",
+				error_code(err, system_category()).message()
+			);
+		}
 
-					this_thread::sleep_for(chrono::milliseconds(ENOMEM_count));
-					continue;
-				}
+		passThru.set_value(0);
 
-				if (errno == EINTR) {
-					tImgTransLogWarn("Recieve interrupted by a system signal");
-					continue;  // Interrupted by signal, just try again
-				}
+		auto backend = options.backend;
+#ifndef __linux__
+		if (backend != Backend::CLASSIC) {
+			tImgTransLogWarn(
+				"Receive backend {} is Linux only, falling back to CLASSIC", backendName(backend)
+			);
+			backend = Backend::CLASSIC;
+		}
+#endif
+		activeBackend.store(backend);
 
-				if (errno == ECONNREFUSED || errno == ENOTCONN) [[unlikely]] {
-					tImgTransLogWarn(
-						"Recieve failed with error: {}, ignoring this",
-						error_code(errno, system_category()).message()
-					);
-					continue;  // These errors should not happen as there is no connection and send at all
-				}
+		switch (backend) {
+#ifdef __linux__
+			case Backend::BATCHED:
+				recvLoopBatched(sToken);
+				break;
+			case Backend::ZERO_COPY:
+				recvLoopZeroCopy(sToken);
+				break;
+			case Backend::IO_URING:
+				if (recvLoopUring(sToken)) { break; }
 
-				tImgTransLogError(
-					"Receive failed with error: {}. Stopping receive thread.",
-					error_code(errno, system_category()).message()
-				);
-				onRecvError(errno);
+				tImgTransLogWarn("io_uring receive backend unavailable, falling back to CLASSIC");
+				activeBackend.store(Backend::CLASSIC);
+				recvLoopClassic(sToken);
+				break;
+#endif
+			case Backend::CLASSIC:
+			default:
+				recvLoopClassic(sToken);
 				break;
-			}
 		}
 
 		tImgTransLogTrace("UDP Receive thread stopped");
@@ -158,53 +1135,45 @@ int TRecv::start()
 	return threadErr;
 }
 
-i32 TRecv::bindV4(u16 port, const char* ip)
+template<typename Policy>
+i32 TBasicRecv<Policy>::bindV4(u16 port, const char* ip)
 {
 	stop();
 
 	updSock.closeSock();
-	auto newSockFd = ::socket(AF_INET, SOCK_DGRAM, 0);
-
-	if (newSockFd < 0) {
-		tImgTransLogError(
-			"Failed to create new socket, error: {}", error_code(errno, system_category()).message()
-		);
-		return errno;
-	}
-
-	sockaddr_in newAddr{};
 
 	auto v4Addr = V4Addr::create(ip, port);
 	if (!v4Addr.has_value()) {
 		tImgTransLogError("Invalid IP address: {}:{}", ip, port);
-		::close(newSockFd);
 		return EINVAL;  // Invalid argument
 	}
 
-	newAddr.sin_family      = AF_INET;
-	newAddr.sin_addr.s_addr = v4Addr->ip;
-	newAddr.sin_port        = htons(v4Addr->port);
-
-	if (::bind(newSockFd, reinterpret_cast<sockaddr*>(&newAddr), sizeof(newAddr)) < 0) {
+	auto newAddr   = TUdpSock::makeV4Addr(v4Addr->ip, v4Addr->port);
+	auto newSockFd = TUdpSock::bindV4(newAddr);
+	if (newSockFd < 0) {
 		tImgTransLogError(
 			"Failed to bind socket to ip: {}, error: {}",
 			v4Addr->toString(),
-			error_code(errno, system_category()).message()
+			error_code(-newSockFd, system_category()).message()
 		);
-		::close(newSockFd);
-		return errno;
+		return -newSockFd;
 	}
 
-	updSock    = newSockFd;
-	listenAddr = newAddr;
+	updSock         = newSockFd;
+	listenAddr      = newAddr;
+	lastDropCounter = 0;  // SO_RXQ_OVFL counts per socket, it restarts from 0 on a new one
 
 	tImgTransLogInfo("New socket created, bound to {}", v4Addr->toString());
 
 	return 0;
 }
 
-TRecv::TRecv(TReassembly::SharedPtr _reassembler, u16 _port, const char* _ip) :
-	reassembler(std::move(_reassembler))
+template<typename Policy>
+TBasicRecv<Policy>::TBasicRecv(
+	ReassemblerPtr _reassembler, u16 _port, const char* _ip, Options _options
+) :
+	reassembler(std::move(_reassembler)),
+	options(_options)
 {
 	if (!reassembler) {
 		if constexpr (!conf::TDebugMode) {
@@ -219,6 +1188,14 @@ TRecv::TRecv(TReassembly::SharedPtr _reassembler, u16 _port, const char* _ip) :
 		}
 	}
 
+	if (options.impairment.isEnabled()) {
+		impairment = TImpairment::create(options.impairment, mtuLen);
+
+		if (options.backend == Backend::ZERO_COPY) {
+			tImgTransLogWarn("Impairment enabled, ZERO_COPY will copy every datagram.");
+		}
+	}
+
 	auto bindResult = bindV4(_port, _ip);
 	if (bindResult != 0) {
 		tImgTransLogError(
@@ -230,9 +1207,13 @@ TRecv::TRecv(TReassembly::SharedPtr _reassembler, u16 _port, const char* _ip) :
 	}
 }
 
-TRecv::~TRecv()
+template<typename Policy>
+TBasicRecv<Policy>::~TBasicRecv()
 {
 	tImgTransLogDebug("TRecv released, closing socket...");
 }
 
-}  // namespace gentau
\ No newline at end of file
+template class TBasicRecv<TDefaultReAsmPolicy>;
+template class TBasicRecv<TSmallMtuReAsmPolicy>;
+template class TBasicRecv<TJumboReAsmPolicy>;
+}  // namespace gentau
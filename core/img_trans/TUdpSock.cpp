@@ -0,0 +1,75 @@
+#include "img_trans/net/TUdpSock.hpp"
+
+#include <unistd.h>
+
+#include <cerrno>
+
+#include <optional>
+
+using namespace std;
+
+namespace gentau {
+i32 TUdpSock::bindV4(const sockaddr_in& addr) noexcept
+{
+	auto sock = ::socket(AF_INET, SOCK_DGRAM, 0);
+	if (sock < 0) { return -errno; }
+
+	if (::bind(sock, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0) {
+		auto err = errno;
+		::close(sock);
+		return -err;
+	}
+
+	return sock;
+}
+
+i32 TUdpSock::setRecvBuffer(int sock, i32 size) noexcept
+{
+#ifdef __linux__
+	if (::setsockopt(sock, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)) == 0) { return 0; }
+#endif
+	if (::setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size)) < 0) { return errno; }
+	return 0;
+}
+
+optional<i32> TUdpSock::getRecvBuffer(int sock) noexcept
+{
+	i32       size    = 0;
+	socklen_t sizeLen = sizeof(size);
+	if (::getsockopt(sock, SOL_SOCKET, SO_RCVBUF, &size, &sizeLen) < 0) { return nullopt; }
+#ifdef __linux__
+	size /= 2;
+#endif
+	return size;
+}
+
+i32 TUdpSock::setRecvTimeout(int sock, timeval timeout) noexcept
+{
+	if (::setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) < 0) {
+		return errno;
+	}
+	return 0;
+}
+
+i32 TUdpSock::enableTimestamps([[maybe_unused]] int sock) noexcept
+{
+#ifdef SO_TIMESTAMPNS
+	i32 on = 1;
+	if (::setsockopt(sock, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) < 0) { return errno; }
+	return 0;
+#else
+	return ENOTSUP;
+#endif
+}
+
+i32 TUdpSock::enableDropCounter([[maybe_unused]] int sock) noexcept
+{
+#ifdef SO_RXQ_OVFL
+	i32 on = 1;
+	if (::setsockopt(sock, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on)) < 0) { return errno; }
+	return 0;
+#else
+	return ENOTSUP;
+#endif
+}
+}  // namespace gentau
@@ -0,0 +1,303 @@
+#ifdef __linux__
+
+#include "img_trans/net/TUring.hpp"
+
+#include "utils/TLog.hpp"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <vector>
+
+#define T_LOG_TAG_IMG "[io_uring] "
+
+using namespace std;
+
+namespace gentau {
+namespace {
+int sysSetup(u32 entries, io_uring_params* params)
+{
+	return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int sysEnter(int fd, u32 toSubmit, u32 minComplete, u32 flags)
+{
+	return static_cast<int>(
+		::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0)
+	);
+}
+
+int sysRegister(int fd, u32 opcode, void* arg, u32 nrArgs)
+{
+	return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nrArgs));
+}
+
+template<typename T>
+T* ringAt(void* base, u32 offset)
+{
+	return reinterpret_cast<T*>(static_cast<u8*>(base) + offset);
+}
+}  // namespace
+
+u32 TUring::loadAcquire(const u32* p) const noexcept
+{
+	return atomic_ref<u32>(*const_cast<u32*>(p)).load(memory_order_acquire);
+}
+
+void TUring::storeRelease(u32* p, u32 v) noexcept
+{
+	atomic_ref<u32>(*p).store(v, memory_order_release);
+}
+
+bool TUring::isSupported() noexcept
+{
+	static const bool supported = []() {
+		TUring probeRing;
+
+		if (auto err = probeRing.init(4); err != 0) {
+			tImgTransLogInfo("io_uring unavailable: {}", strerror(err));
+			return false;
+		}
+
+		constexpr u32 opsLen = IORING_OP_LAST;
+		vector<u8>    probeMem(sizeof(io_uring_probe) + opsLen * sizeof(io_uring_probe_op), 0);
+		auto          probe = reinterpret_cast<io_uring_probe*>(probeMem.data());
+
+		if (sysRegister(probeRing.ringFd, IORING_REGISTER_PROBE, probe, opsLen) < 0) {
+			tImgTransLogInfo("io_uring opcode probe failed: {}", strerror(errno));
+			return false;
+		}
+
+		for (u8 op : { IORING_OP_RECVMSG, IORING_OP_READ }) {
+			if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+				tImgTransLogInfo("io_uring opcode {} is not supported by the kernel", op);
+				return false;
+			}
+		}
+
+		if (auto err = probeRing.setupBufRing(0, 1, 64); err != 0) {
+			tImgTransLogInfo("io_uring provided-buffer ring unavailable: {}", strerror(err));
+			return false;
+		}
+
+		return true;
+	}();
+
+	return supported;
+}
+
+i32 TUring::init(u32 entries) noexcept
+{
+	release();
+
+	io_uring_params params{};
+	params.flags = IORING_SETUP_COOP_TASKRUN;  // No IPI to interrupt the receiving thread
+
+	int fd = sysSetup(entries, &params);
+	if (fd < 0 && errno == EINVAL) {
+		params = {};  // Kernel older than 5.19, retry without optional flags
+		fd     = sysSetup(entries, &params);
+	}
+	if (fd < 0) { return errno; }
+
+	ringFd    = fd;
+	sqEntries = params.sq_entries;
+
+	sqRingSz = params.sq_off.array + params.sq_entries * sizeof(u32);
+	cqRingSz = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+	bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+	if (singleMmap) { sqRingSz = cqRingSz = max(sqRingSz, cqRingSz); }
+
+	sqRingPtr = ::mmap(
+		nullptr,
+		sqRingSz,
+		PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE,
+		fd,
+		IORING_OFF_SQ_RING
+	);
+	if (sqRingPtr == MAP_FAILED) {
+		sqRingPtr = nullptr;
+		auto err  = errno;
+		release();
+		return err;
+	}
+
+	if (singleMmap) {
+		cqRingPtr = sqRingPtr;
+	} else {
+		cqRingPtr = ::mmap(
+			nullptr,
+			cqRingSz,
+			PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE,
+			fd,
+			IORING_OFF_CQ_RING
+		);
+		if (cqRingPtr == MAP_FAILED) {
+			cqRingPtr = nullptr;
+			auto err  = errno;
+			release();
+			return err;
+		}
+	}
+
+	sqesSz  = params.sq_entries * sizeof(io_uring_sqe);
+	auto sq = ::mmap(
+		nullptr, sqesSz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES
+	);
+	if (sq == MAP_FAILED) {
+		auto err = errno;
+		release();
+		return err;
+	}
+	sqes = static_cast<io_uring_sqe*>(sq);
+
+	sqHead  = ringAt<u32>(sqRingPtr, params.sq_off.head);
+	sqTail  = ringAt<u32>(sqRingPtr, params.sq_off.tail);
+	sqMask  = ringAt<u32>(sqRingPtr, params.sq_off.ring_mask);
+	sqArray = ringAt<u32>(sqRingPtr, params.sq_off.array);
+
+	cqHead = ringAt<u32>(cqRingPtr, params.cq_off.head);
+	cqTail = ringAt<u32>(cqRingPtr, params.cq_off.tail);
+	cqMask = ringAt<u32>(cqRingPtr, params.cq_off.ring_mask);
+	cqes   = ringAt<io_uring_cqe>(cqRingPtr, params.cq_off.cqes);
+
+	return 0;
+}
+
+i32 TUring::setupBufRing(u16 bgid, u32 count, u32 len) noexcept
+{
+	if (!isValid()) { return EBADF; }
+	if (bufRing) { return EEXIST; }
+	if (count == 0 || count > 32768 || !has_single_bit(count) || len == 0) { return EINVAL; }
+
+	// The ring itself must be page aligned, anonymous mmap guarantees that.
+	bufRingSz = count * sizeof(io_uring_buf);
+	auto mem =
+		::mmap(nullptr, bufRingSz, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mem == MAP_FAILED) { return errno; }
+	bufRing = static_cast<io_uring_buf_ring*>(mem);
+
+	bufPoolSz = static_cast<size_t>(count) * len;
+	mem = ::mmap(nullptr, bufPoolSz, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mem == MAP_FAILED) {
+		auto err = errno;
+		::munmap(bufRing, bufRingSz);
+		bufRing = nullptr;
+		return err;
+	}
+	bufPool = static_cast<u8*>(mem);
+
+	bufCount = count;
+	bufLen   = len;
+	bufGroup = bgid;
+	bufTail  = 0;
+
+	io_uring_buf_reg reg{};
+	reg.ring_addr    = reinterpret_cast<u64>(bufRing);
+	reg.ring_entries = count;
+	reg.bgid         = bgid;
+
+	if (sysRegister(ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+		auto err = errno;
+		::munmap(bufPool, bufPoolSz);
+		::munmap(bufRing, bufRingSz);
+		bufPool = nullptr;
+		bufRing = nullptr;
+		return err;
+	}
+	bufRingRegd = true;
+
+	for (u32 i = 0; i < count; i++) { recycleBuffer(static_cast<u16>(i)); }
+	publishBuffers();
+
+	return 0;
+}
+
+io_uring_sqe* TUring::getSqe() noexcept
+{
+	u32 head = loadAcquire(sqHead);
+	u32 tail = *sqTail + sqPending;
+
+	if (tail - head >= sqEntries) { return nullptr; }
+
+	u32  idx = tail & *sqMask;
+	auto sqe = &sqes[idx];
+	memset(sqe, 0, sizeof(io_uring_sqe));
+
+	sqArray[idx] = idx;
+	sqPending++;
+
+	return sqe;
+}
+
+i32 TUring::submit(u32 waitNr) noexcept
+{
+	u32 toSubmit = sqPending;
+	if (toSubmit > 0) {
+		storeRelease(sqTail, *sqTail + toSubmit);
+		sqPending = 0;
+	}
+
+	if (toSubmit == 0 && waitNr == 0) { return 0; }
+
+	u32 flags = waitNr > 0 ? IORING_ENTER_GETEVENTS : 0;
+	if (sysEnter(ringFd, toSubmit, waitNr, flags) < 0) { return errno; }
+
+	return 0;
+}
+
+void TUring::recycleBuffer(u16 bid) noexcept
+{
+	// Not `bufRing->bufs[]`: in C++ the kernel header's flex-array wrapper shifts it by 8 bytes
+	auto& buf = reinterpret_cast<io_uring_buf*>(bufRing)[bufTail & (bufCount - 1)];
+	buf.addr  = reinterpret_cast<u64>(bufPool + static_cast<size_t>(bid) * bufLen);
+	buf.len   = bufLen;
+	buf.bid   = bid;
+	bufTail++;
+}
+
+void TUring::publishBuffers() noexcept
+{
+	atomic_ref<u16>(bufRing->tail).store(bufTail, memory_order_release);
+}
+
+void TUring::release() noexcept
+{
+	if (bufRingRegd) {
+		io_uring_buf_reg reg{};
+		reg.bgid = bufGroup;
+		sysRegister(ringFd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+		bufRingRegd = false;
+	}
+
+	if (sqes) { ::munmap(sqes, sqesSz); }
+	if (cqRingPtr && cqRingPtr != sqRingPtr) { ::munmap(cqRingPtr, cqRingSz); }
+	if (sqRingPtr) { ::munmap(sqRingPtr, sqRingSz); }
+
+	if (ringFd > -1) { ::close(ringFd); }
+
+	// Buffers are unmapped after the ring is gone so the kernel can not write into them anymore
+	if (bufPool) { ::munmap(bufPool, bufPoolSz); }
+	if (bufRing) { ::munmap(bufRing, bufRingSz); }
+
+	sqes      = nullptr;
+	sqRingPtr = nullptr;
+	cqRingPtr = nullptr;
+	bufPool   = nullptr;
+	bufRing   = nullptr;
+	ringFd    = -1;
+	sqPending = 0;
+}
+}  // namespace gentau
+
+#endif  // __linux__
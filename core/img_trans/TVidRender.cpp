@@ -9,7 +9,10 @@
 #include <gst/app/app.h>
 #include <gst/gst.h>
 
+#include <chrono>
+#include <cstring>
 #include <exception>
+#include <fstream>
 #include <future>
 #include <mutex>
 #include <stdexcept>
@@ -32,6 +35,44 @@ constexpr gint64 MAX_RENDER_DELAY = -1;
 constexpr auto MAX_RENDER_DELAY = 25 * GST_MSECOND;
 #endif
 
+// Caps are created once and never freed, GstReferenceTimestampMeta only takes a reference
+static GstCaps* rxTimestampCaps()
+{
+	static GstCaps* caps = gst_caps_new_empty_simple("timestamp/x-unix");
+	return caps;
+}
+
+static GstCaps* pushTimestampCaps()
+{
+	static GstCaps* caps = gst_caps_new_empty_simple("timestamp/x-gentau-push");
+	return caps;
+}
+
+static GstClockTime toGstWallTime(TVidRender::WallTimePoint tp) noexcept
+{
+	return static_cast<GstClockTime>(
+		chrono::duration_cast<chrono::nanoseconds>(tp.time_since_epoch()).count()
+	);
+}
+
+static void attachRxTimestamps(GstBuffer* buffer, const TVidRender::RxTimestamps& rxTs)
+{
+	if (rxTs.isValid()) {
+		gst_buffer_add_reference_timestamp_meta(
+			buffer,
+			rxTimestampCaps(),
+			toGstWallTime(rxTs.first),
+			static_cast<GstClockTime>(
+				chrono::duration_cast<chrono::nanoseconds>(rxTs.last - rxTs.first).count()
+			)
+		);
+	}
+
+	gst_buffer_add_reference_timestamp_meta(
+		buffer, pushTimestampCaps(), toGstWallTime(chrono::system_clock::now()), GST_CLOCK_TIME_NONE
+	);
+}
+
 static TVidRender::StateType convGstState(GstState state) noexcept
 {
 	using StateType = TVidRender::StateType;
@@ -50,6 +91,32 @@ static TVidRender::StateType convGstState(GstState state) noexcept
 	}
 }
 
+static const char* pageModeName(TFramePool::PageMode mode) noexcept
+{
+	using PageMode = TFramePool::PageMode;
+
+	switch (mode) {
+		case PageMode::SMALL:
+			return "small";
+		case PageMode::TRANSPARENT_HUGE:
+			return "transparent huge";
+		case PageMode::EXPLICIT_HUGE:
+			return "explicit huge";
+		default:
+			return "unknown";
+	}
+}
+
+// MADV_HUGEPAGE succeeds even when THP is switched off system-wide, so look at the setting
+static bool thpDisabled()
+{
+	std::ifstream file("/sys/kernel/mm/transparent_hugepage/enabled");
+	std::string   setting;
+	std::getline(file, setting);
+
+	return setting.find("[never]") != std::string::npos;
+}
+
 void TVidRender::onDecoderPadAdded(GstElement* decoder, GstPad* new_pad, gpointer user_data)
 {
 	TVidRender* self               = static_cast<TVidRender*>(user_data);
@@ -142,6 +209,11 @@ bool TVidRender::initBusThread()
 
 	// lamba捕获变量时会默认将其视为const成员
 	busThread = jthread([this, passThru = std::move(threadErrPassThru)](stop_token sToken) mutable {
+		if (!busThreadPolicy.isDefault()) {
+			[[maybe_unused]] auto applied = busThreadPolicy.apply("gt-render-bus");
+			tImgTransLogInfo("Bus thread policy applied: {}", applied.toString());
+		}
+
 		g_autoptr(GstBus) bus = gst_element_get_bus(fixedPipe);
 
 		if (!bus) {
@@ -437,9 +509,17 @@ bool TVidRender::initPipeElements(bool useFileSrc, const char* filePath)
 	return res;
 }
 
-TVidRender::TVidRender(const char* _filePath, u64 _maxBufferBytes, bool _enableTestMode) :
+TVidRender::TVidRender(
+	const char*         _filePath,
+	u64                 _maxBufferBytes,
+	bool                _enableTestMode,
+	TThreadPolicy       _busThreadPolicy,
+	TFramePool::Options _poolOptions
+) :
+	framePool(_poolOptions),
 	useFileSrc(true),
-	enableTestMode(_enableTestMode)
+	enableTestMode(_enableTestMode),
+	busThreadPolicy(std::move(_busThreadPolicy))
 {
 	// Check in compile-time
 	if constexpr (conf::TDebugMode) {
@@ -453,9 +533,16 @@ TVidRender::TVidRender(const char* _filePath, u64 _maxBufferBytes, bool _enableT
 	}
 }
 
-TVidRender::TVidRender(u64 _maxBufferBytes, bool _enableTestMode) :
+TVidRender::TVidRender(
+	u64                 _maxBufferBytes,
+	bool                _enableTestMode,
+	TThreadPolicy       _busThreadPolicy,
+	TFramePool::Options _poolOptions
+) :
+	framePool(_poolOptions),
 	useFileSrc(false),
-	enableTestMode(_enableTestMode)
+	enableTestMode(_enableTestMode),
+	busThreadPolicy(std::move(_busThreadPolicy))
 {
 	initPipeElements(false);
 	maxBufferBytes.store(_maxBufferBytes);
@@ -542,7 +629,9 @@ bool TVidRender::__TEST_ONLY_tryPushFrame_UNSAFE_WHO_USE_WHO_SB_(TVidRender::Fra
 	return false;
 }
 
-bool TVidRender::tryPushFrame(TFramePool::FrameData&& frame, TReassemblyPasskey)
+bool TVidRender::tryPushFrame(
+	TFramePool::FrameData&& frame, RxTimestamps rxTs, TReassemblyPasskey
+)
 {
 	if (!fixedPipe || !fixedSrc) {
 		tImgTransLogError("Push frame failed: Pipeline is not initialized.");
@@ -577,7 +666,7 @@ bool TVidRender::tryPushFrame(TFramePool::FrameData&& frame, TReassemblyPasskey)
 	GstBuffer* buffer = gst_buffer_new_wrapped_full(
 		static_cast<GstMemoryFlags>(0),  // Standard buffer, can be writable(?)
 		frameDataPtr->data(),
-		TFramePool::slotLen,
+		frameDataPtr->capacity(),
 		0,
 		frameDataPtr->getDataLen(),
 		frameDataPtr,
@@ -585,6 +674,8 @@ bool TVidRender::tryPushFrame(TFramePool::FrameData&& frame, TReassemblyPasskey)
 	);
 
 	if (buffer) {
+		attachRxTimestamps(buffer, rxTs);
+
 		// Push may success at GST_STATE_PAUSED or GST_STATE_PLAYING
 		auto ret = gst_app_src_push_buffer(GST_APP_SRC(fixedSrc), buffer);
 		if (ret == GST_FLOW_OK) {
@@ -603,6 +694,49 @@ bool TVidRender::tryPushFrame(TFramePool::FrameData&& frame, TReassemblyPasskey)
 	return false;
 }
 
+bool TVidRender::setFramePoolBacking(TFramePool::PageMode pages, bool lock)
+{
+	using PageMode = TFramePool::PageMode;
+
+	bool exact = true;
+	auto err   = framePool.setPageMode(pages);
+
+	if (err != 0 && pages == PageMode::EXPLICIT_HUGE) {
+		tImgTransLogWarn(
+			"Explicit huge pages refused for the frame pool ({}), trying transparent huge pages.",
+			strerror(err)
+		);
+		exact = false;
+		err   = framePool.setPageMode(PageMode::TRANSPARENT_HUGE);
+	}
+
+	if (err != 0) {
+		tImgTransLogWarn("Huge pages refused for the frame pool: {}", strerror(err));
+		exact = false;
+	} else if (framePool.getPageMode() == PageMode::TRANSPARENT_HUGE && thpDisabled()) {
+		tImgTransLogWarn("Transparent huge pages are disabled system-wide, using small pages.");
+		exact = false;
+	}
+
+	if (auto lockErr = framePool.setLocked(lock); lockErr != 0) {
+		tImgTransLogWarn(
+			"Failed to {} the frame pool: {}{}",
+			lock ? "lock" : "unlock",
+			strerror(lockErr),
+			lockErr == ENOMEM ? ", check RLIMIT_MEMLOCK (ulimit -l)" : ""
+		);
+		exact = false;
+	}
+
+	tImgTransLogInfo(
+		"Frame pool backed by {} pages{}.",
+		pageModeName(framePool.getPageMode()),
+		framePool.isLocked() ? ", locked in memory" : ""
+	);
+
+	return exact;
+}
+
 bool TVidRender::play()
 {
 	if (!pipeline()) {
@@ -655,6 +789,8 @@ bool TVidRender::restart()
 		return false;
 	}
 
+	decoderResets.fetch_add(1);
+
 	tImgTransLogInfo("Pipeline reset success");
 	return true;
 }
@@ -699,6 +835,8 @@ bool TVidRender::flush()
 	if (currentCaps) { g_object_set(fixedSrc, "caps", currentCaps, nullptr); }
 #endif
 
+	decoderResets.fetch_add(1);
+
 	tImgTransLogInfo("Pipeline flushed successfully.");
 	return true;
 }
@@ -4,8 +4,11 @@
 #include "img_trans/net/TRecv.hpp"
 #include "img_trans/vid_render/TVidRender.hpp"
 
+#include "utils/TThreadPolicy.hpp"
 #include "utils/TTypeRedef.hpp"
 
+#include <utility>
+
 namespace gentau {
 /**
  * TImgTrans 是对网络接收、数据重组和视频渲染模块的轻度包装，它保证了底层组件的初始化顺序正确与生命周期的统一。
@@ -18,6 +21,10 @@ namespace gentau {
  *
  * 请参考 tests/render/rend-net.cpp 中的示例用法，但需要注意该例程不适合直接用于生产环境中。
  *
+ * 模板参数 `Policy` 为重组策略（参见 TReAsmPolicy），决定 TBasicReassembly 与 TBasicRecv 的
+ * 编译期常量（MTU、槽位数、超时等）。例如巨型帧局域网可使用 TBasicImgTrans<TJumboReAsmPolicy>，
+ * 一般情况下使用默认策略的别名 TImgTrans 即可。
+ *
  * 通过 TImgTrans 使用 TVidRender 时，请永远不要直接调用 TVidRender::tryPushFrame(TVidRender::FramePtr) 
  * 方法，该方法仅用于测试目的，否则可能会在 Debug 构建下导致非常严重的安全性问题（因为它允许任意帧数据被推送到管道中），
  * 在非 Debug 构建下该方法无任何实际效果与副作用，但仍然不建议调用以免造成误解。让底层组件自行处理数据的流转才是 TImgTrans 
@@ -25,42 +32,68 @@ namespace gentau {
  *
  * @note TImgTrans 的成员均有文档注释，强烈建议在使用前仔细阅读这些注释以避免误用。
  */
-class TImgTrans
+template<typename Policy = TDefaultReAsmPolicy>
+class TBasicImgTrans
 {
   public:
-	using SharedPtr = std::shared_ptr<TImgTrans>;
+	using SharedPtr  = std::shared_ptr<TBasicImgTrans>;
+	using Reassembly = TBasicReassembly<Policy>;
+	using Recv       = TBasicRecv<Policy>;
 
   public:
-	const TVidRender::SharedPtr  renderer;
-	const TReassembly::SharedPtr reassembler;
-	const TRecv::UniPtr          receiver;
+	const TVidRender::SharedPtr          renderer;
+	const typename Reassembly::SharedPtr reassembler;
+	const typename Recv::UniPtr          receiver;
 
   public:
 	static void initContext(int* argc, char** argv[]) { TVidRender::initContext(argc, argv); }
 
   public:
-	explicit TImgTrans(
-		u64 _maxBufferBytes = 262'144, u16 recvPort = 3334, const char* recvIp = "127.0.0.1"
+	explicit TBasicImgTrans(
+		u64                 _maxBufferBytes = 262'144,
+		u16                 recvPort        = 3334,
+		const char*         recvIp          = "127.0.0.1",
+		TRecvOptions        recvOptions     = {},
+		TThreadPolicy       busThreadPolicy = {},
+		TFramePool::Options poolOptions     = {}
 	) :
-		renderer(TVidRender::create(_maxBufferBytes)),
-		reassembler(TReassembly::create(renderer)),
-		receiver(TRecv::createUni(reassembler, recvPort, recvIp)) {};
+		renderer(TVidRender::create(_maxBufferBytes, std::move(busThreadPolicy), poolOptions)),
+		reassembler(Reassembly::create(renderer)),
+		receiver(Recv::createUni(reassembler, recvPort, recvIp, recvOptions)) {};
 
 	/**
      * 创建一个 TImgTrans 实例。
      * @param maxBufferBytes 最大缓冲区大小（字节）
      * @param recvPort 接收端口
      * @param recvIp 接收 IP 地址
+     * @param recvOptions 接收后端选项，参见 TRecvOptions（接收线程的调度策略亦在其中设置）
+     * @param busThreadPolicy 渲染管线总线线程的调度策略，参见 TThreadPolicy
+     * @param poolOptions 帧缓冲池各级的初始槽位数、增长上限与收缩周期，参见 TFramePoolOptions
      * @return TImgTrans 的共享指针
      * @throws std::runtime_error 如果管道初始化失败。
+     * @throws std::invalid_argument 如果 poolOptions 中某一级的上限小于其初始槽位数。
      */
 	[[nodiscard("Should not ignored the created TImgTrans::SharedPtr")]] static SharedPtr create(
-		u64 maxBufferBytes = 262'144, u16 recvPort = 3334, const char* recvIp = "127.0.0.1"
+		u64                 maxBufferBytes  = 262'144,
+		u16                 recvPort        = 3334,
+		const char*         recvIp          = "127.0.0.1",
+		TRecvOptions        recvOptions     = {},
+		TThreadPolicy       busThreadPolicy = {},
+		TFramePool::Options poolOptions     = {}
 	)
 	{
-		return std::make_shared<TImgTrans>(maxBufferBytes, recvPort, recvIp);
+		return std::make_shared<TBasicImgTrans>(
+			maxBufferBytes,
+			recvPort,
+			recvIp,
+			std::move(recvOptions),
+			std::move(busThreadPolicy),
+			poolOptions
+		);
 	}
 
-	~TImgTrans() = default;
+	~TBasicImgTrans() = default;
 };
+
+using TImgTrans = TBasicImgTrans<>;
 }  // namespace gentau
\ No newline at end of file
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "img_trans/vid_render/TVidRender.hpp"
+
+#include "utils/TTypeRedef.hpp"
+
+#include <chrono>
+#include <memory>
+#include <span>
+#include <string>
+
+namespace gentau {
+/**
+ * @brief Capture file layout shared by TCaptureRecorder and TCapturePacketSource.
+ *
+ * The file starts with a FileHeader, followed by back to back records. Each record is a
+ * RecordHeader immediately followed by `len` bytes of datagram (including the 8-byte
+ * protocol header), padded to an 8-byte boundary. All fields are little-endian.
+ */
+struct TCaptureFormat
+{
+	static constexpr char magic[8] = { 'G', 'T', 'C', 'A', 'P', 'T', 'U', 'R' };
+	static constexpr u32  version  = 1;
+
+	struct FileHeader
+	{
+		char magic[8];
+		u32  version;
+		u32  reserved;
+	};
+	static_assert(sizeof(FileHeader) == 16, "FileHeader size must be 16 bytes");
+
+	struct RecordHeader
+	{
+		u64 arrivalNs;  // Monotonic arrival time, relative to the first record of the capture
+		i64 rxTimeNs;   // Kernel wall-clock arrival time since epoch, 0 if unknown
+		u32 len;        // Datagram length
+		u32 reserved;
+	};
+	static_assert(sizeof(RecordHeader) == 24, "RecordHeader size must be 24 bytes");
+
+	static constexpr u64 recordAlign = 8;
+
+	static constexpr u64 paddedLen(u64 len) noexcept
+	{
+		return (len + recordAlign - 1) & ~(recordAlign - 1);
+	}
+};
+
+/**
+ * @brief Appends datagrams to a capture file (see TCaptureFormat) through a shared memory
+ *        mapping.
+ *
+ * The file is preallocated in chunks of `growStep` bytes (fallocate), so running out of disk
+ * space is reported by `append()` instead of raising SIGBUS on a write to the mapping. `close()`
+ * trims the file down to the records actually written.
+ *
+ * @note NOT MT-SAFE, the owner is expected to serialize the calls.
+ */
+class TCaptureRecorder
+{
+  public:
+	using UniPtr    = std::unique_ptr<TCaptureRecorder>;
+	using TimePoint = std::chrono::steady_clock::time_point;
+
+	static constexpr u64 growStep = 64ull * 1024 * 1024;  // 64 MiB, about 45k full datagrams
+
+  private:
+	int fd       = -1;
+	u8* mapped   = nullptr;
+	u64 capacity = 0;  // Bytes allocated and mapped
+	u64 cursor   = 0;  // Offset of the next record
+	i32 lastErr  = 0;
+
+	u64       records = 0;
+	TimePoint firstArrival{};
+
+  private:
+	i32 reserve(u64 len) noexcept;
+
+  public:
+	/**
+	 * @brief Append a datagram, given as its protocol header and payload or as a whole in
+	 *        `head` with an empty `payload`.
+	 * @param rxTime Kernel arrival time, default constructed if unknown.
+	 * @param arrival Arrival time on the monotonic clock, used for the paced replay.
+	 * @return 0 on success, otherwise the errno code (e.g. ENOSPC). Once an append failed,
+	 *         the recorder stays failed and only `close()` is meaningful.
+	 */
+	i32 append(
+		std::span<const u8>       head,
+		std::span<const u8>       payload,
+		TVidRender::WallTimePoint rxTime,
+		TimePoint                 arrival
+	) noexcept;
+
+	/**
+	 * @brief Unmap the file and trim it to the records written. Called by the destructor.
+	 * @return 0 on success, otherwise the errno code.
+	 */
+	i32 close() noexcept;
+
+	bool isOpen() const noexcept { return mapped != nullptr && lastErr == 0; }
+	i32  getError() const noexcept { return lastErr; }
+	u64  getRecordCount() const noexcept { return records; }
+	u64  getBytes() const noexcept { return cursor; }
+
+  public:
+	/**
+	 * @brief Create (or truncate) the capture file at `path`.
+	 * @note Failing to create or map the file is logged and leaves the recorder closed,
+	 *       `getError()` then returns the errno code.
+	 */
+	explicit TCaptureRecorder(const std::string& path);
+
+	[[nodiscard("Should not ignored the created TCaptureRecorder::UniPtr")]] static UniPtr create(
+		const std::string& path
+	)
+	{
+		return std::make_unique<TCaptureRecorder>(path);
+	}
+
+	~TCaptureRecorder() { close(); }
+
+	TCaptureRecorder(const TCaptureRecorder&)            = delete;
+	TCaptureRecorder& operator=(const TCaptureRecorder&) = delete;
+	TCaptureRecorder(TCaptureRecorder&&)                 = delete;
+	TCaptureRecorder& operator=(TCaptureRecorder&&)      = delete;
+};
+}  // namespace gentau
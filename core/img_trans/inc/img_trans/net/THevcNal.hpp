@@ -0,0 +1,99 @@
+#pragma once
+
+#include "utils/TTypeRedef.hpp"
+
+#include <cstring>
+#include <span>
+
+namespace gentau {
+/**
+ * @brief H.265 Annex-B 码流中的一个 NAL 单元，由 TAnnexBScanner 给出。
+ */
+struct THevcNal
+{
+	static constexpr u8 RASL_N     = 8;
+	static constexpr u8 RASL_R     = 9;
+	static constexpr u8 BLA_W_LP   = 16;  // First IRAP type
+	static constexpr u8 IDR_W_RADL = 19;
+	static constexpr u8 IDR_N_LP   = 20;
+	static constexpr u8 CRA_NUT    = 21;
+	static constexpr u8 RSV_IRAP   = 23;  // Last IRAP type (reserved)
+	static constexpr u8 VPS_NUT    = 32;
+	static constexpr u8 SPS_NUT    = 33;
+	static constexpr u8 PPS_NUT    = 34;
+	static constexpr u8 AUD_NUT    = 35;
+	static constexpr u8 unknown    = 0xff;  // The NAL unit header was cut off
+
+	u32 start  = 0;        // Offset of the start code (its leading zero byte if 4 bytes long)
+	u32 header = 0;        // Offset of the 2-byte NAL unit header
+	u8  type   = unknown;  // nal_unit_type
+
+	static constexpr bool isVcl(u8 nalType) noexcept { return nalType < 32; }
+	static constexpr bool isIrap(u8 nalType) noexcept
+	{
+		return nalType >= BLA_W_LP && nalType <= RSV_IRAP;
+	}
+	static constexpr bool isRasl(u8 nalType) noexcept
+	{
+		return nalType == RASL_N || nalType == RASL_R;
+	}
+	static constexpr bool isParamSet(u8 nalType) noexcept
+	{
+		return nalType >= VPS_NUT && nalType <= PPS_NUT;
+	}
+
+	bool isVcl() const noexcept { return isVcl(type); }
+	bool isIrap() const noexcept { return isIrap(type); }
+	bool isRasl() const noexcept { return isRasl(type); }
+	bool isParamSet() const noexcept { return isParamSet(type); }
+};
+
+/**
+ * @brief 按 Annex-B 起始码（00 00 01 / 00 00 00 01）遍历 H.265 码流中的 NAL 单元。
+ *
+ * 防竞争字节（emulation prevention）保证 NAL 单元内部不会出现 00 00 01，因此每一处匹配都是起始码。
+ * 一个 NAL 单元在下一个起始码出现之前都不能确定已经完整。
+ */
+class TAnnexBScanner
+{
+  private:
+	const u8* data;
+	u32       len;
+	u32       pos = 2;  // Where the 0x01 of the next start code may be
+
+  public:
+	/**
+	 * @brief 找到下一个起始码。
+	 * @return 若码流中已没有起始码，返回 false。
+	 */
+	bool next(THevcNal& nal) noexcept
+	{
+		while (pos < len) {
+			auto hit = static_cast<const u8*>(memchr(data + pos, 0x01, len - pos));
+			if (!hit) { break; }
+
+			pos = static_cast<u32>(hit - data);
+			if (data[pos - 1] != 0 || data[pos - 2] != 0) {
+				pos++;
+				continue;
+			}
+
+			nal.start  = (pos >= 3 && data[pos - 3] == 0) ? pos - 3 : pos - 2;
+			nal.header = pos + 1;
+			nal.type   = nal.header < len ? (data[nal.header] >> 1) & 0x3f : THevcNal::unknown;
+
+			pos += 3;  // Past the 2-byte NAL unit header
+			return true;
+		}
+
+		pos = len;
+		return false;
+	}
+
+  public:
+	explicit TAnnexBScanner(std::span<const u8> stream) noexcept :
+		data(stream.data()),
+		len(static_cast<u32>(stream.size()))
+	{}
+};
+}  // namespace gentau
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "img_trans/net/TPacketSource.hpp"
+#include "img_trans/net/TReAsmPolicy.hpp"
+
+#include "utils/TTypeRedef.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace gentau {
+/**
+ * @brief Settings of the network impairment stage, see TImpairment. Every probability is
+ *        per datagram and in [0, 1]. The default constructed options impair nothing.
+ */
+struct TImpairmentOptions
+{
+	using Duration = std::chrono::microseconds;
+
+	u64 seed = 1;  // Same seed and same datagram sequence, same impairments
+
+	f64 lossRate = 0.0;  // Independent random loss
+
+	// Bursty loss, a two-state Gilbert-Elliott channel. `burstEnter` is the chance to go from
+	// the good state to the bad one, `burstExit` to come back; in the bad state datagrams are
+	// lost with `burstLossRate`. The mean burst length is 1 / `burstExit` datagrams.
+	f64 burstEnter    = 0.0;
+	f64 burstExit     = 0.5;
+	f64 burstLossRate = 1.0;
+
+	f64 duplicateRate = 0.0;  // The copy follows the original after a fresh delay draw
+
+	// Datagrams picked for reordering are held `reorderDelay` longer, the ones behind them
+	// overtake them
+	f64      reorderRate  = 0.0;
+	Duration reorderDelay = std::chrono::milliseconds(2);
+
+	// Every datagram is held `delay` plus a uniform draw in [0, `jitter`]. A jitter larger than
+	// the datagram spacing reorders datagrams too, like netem does.
+	Duration delay  = Duration::zero();
+	Duration jitter = Duration::zero();
+
+	u32 maxHeld = 4096;  // Datagrams held at once, beyond this they pass through unimpaired
+
+	bool isEnabled() const noexcept
+	{
+		return lossRate > 0.0 || burstEnter > 0.0 || duplicateRate > 0.0 || reorderRate > 0.0 ||
+			   delay > Duration::zero() || jitter > Duration::zero();
+	}
+};
+
+/**
+ * @brief Seeded, in-process network impairment: loss (random and bursty), reordering,
+ *        duplication and delay jitter, applied to the datagrams before they reach
+ *        `TReassembly::onPacketRecv()`.
+ *
+ * The decisions only depend on the seed and the order of the submitted datagrams, the random
+ * generator (splitmix64) is the same on every platform. Held datagrams are copied into a
+ * preallocated pool and released by `popDue()` once their release time has passed.
+ *
+ * @note NOT MT-SAFE, meant to live on the receiving (or feeding) thread. `getStats()` is
+ *       MT-SAFE.
+ */
+class TImpairment
+{
+  public:
+	using UniPtr    = std::unique_ptr<TImpairment>;
+	using TimePoint = std::chrono::steady_clock::time_point;
+	using Options   = TImpairmentOptions;
+
+	enum class Verdict : u8
+	{
+		PASS = 0,  // Deliver the datagram right now, nothing was copied
+		DROP,      // The datagram is lost
+		HELD,      // The datagram was copied and will come out of popDue() later
+	};
+
+	struct Stats
+	{
+		u64 submitted  = 0;
+		u64 lost       = 0;  // Random and burst losses
+		u64 burstLost  = 0;  // Part of `lost`, taken in the bad state of the burst model
+		u64 duplicated = 0;
+		u64 reordered  = 0;
+		u64 delayed    = 0;  // Held for delay / jitter (reordered ones not included)
+		u64 overflowed = 0;  // Passed unimpaired because `maxHeld` datagrams were held already
+	};
+
+  private:
+	struct Held
+	{
+		TimePoint                 releaseAt;
+		u64                       seq;  // Submission order, breaks ties in release time
+		u32                       slot;
+		u32                       len;
+		TVidRender::WallTimePoint rxTime;
+	};
+
+	const Options options;
+	const u32     slotLen;  // Longest datagram that can be held
+
+	u64  rngState = 0;
+	bool inBurst  = false;
+	u64  seq      = 0;
+
+	std::vector<u8>   pool;  // `maxHeld` slots of `slotLen` bytes
+	std::vector<u32>  freeSlots;
+	std::vector<Held> heap;  // Min-heap on (releaseAt, seq)
+	u32               releasedSlot = UINT32_MAX;
+
+	std::atomic<u64> submitted  = 0;
+	std::atomic<u64> lost       = 0;
+	std::atomic<u64> burstLost  = 0;
+	std::atomic<u64> duplicated = 0;
+	std::atomic<u64> reordered  = 0;
+	std::atomic<u64> delayed    = 0;
+	std::atomic<u64> overflowed = 0;
+
+  private:
+	f64                 nextUniform() noexcept;  // [0, 1)
+	TimePoint::duration drawDelay() noexcept;
+
+	// Copy the datagram into the pool, false if the pool is exhausted
+	bool hold(std::span<const u8> packet, TVidRender::WallTimePoint rxTime, TimePoint at);
+
+	u8* slotData(u32 slot) noexcept { return pool.data() + static_cast<size_t>(slot) * slotLen; }
+
+  public:
+	/**
+	 * @brief Decide the fate of a received datagram.
+	 * @param now Arrival time on the monotonic clock, the delays are relative to it.
+	 */
+	Verdict submit(std::span<const u8> packet, TVidRender::WallTimePoint rxTime, TimePoint now);
+
+	/**
+	 * @brief Pop the next held datagram whose release time is not after `now`.
+	 * @return false if no held datagram is due yet. On success `out` points into the pool and
+	 *         stays valid until the next call to `popDue()` or `submit()`.
+	 */
+	bool popDue(TimePoint now, TPacket& out);
+
+	/**
+	 * @brief Release time of the earliest held datagram, TimePoint::max() if none is held.
+	 */
+	TimePoint nextRelease() const noexcept
+	{
+		return heap.empty() ? TimePoint::max() : heap.front().releaseAt;
+	}
+
+	u32 getHeldCount() const noexcept { return static_cast<u32>(heap.size()); }
+
+	/**
+	 * @note MT-SAFE
+	 */
+	Stats getStats() const noexcept;
+
+	const Options& getOptions() const noexcept { return options; }
+
+  public:
+	/**
+	 * @param maxPacketLen Longer datagrams are never held, they pass through unimpaired.
+	 */
+	explicit TImpairment(const Options& _options, u32 maxPacketLen = MTU_LEN);
+
+	[[nodiscard("Should not ignored the created TImpairment::UniPtr")]] static UniPtr create(
+		const Options& _options, u32 maxPacketLen = MTU_LEN
+	)
+	{
+		return std::make_unique<TImpairment>(_options, maxPacketLen);
+	}
+
+	~TImpairment() = default;
+
+	TImpairment(const TImpairment&)            = delete;
+	TImpairment& operator=(const TImpairment&) = delete;
+};
+}  // namespace gentau
@@ -0,0 +1,395 @@
+#pragma once
+
+#include "img_trans/net/TCapture.hpp"
+#include "img_trans/net/TReassembly.hpp"
+
+#include "utils/TTypeRedef.hpp"
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+namespace gentau {
+class TImpairment;
+struct TImpairmentOptions;
+
+/**
+ * @brief A datagram handed out by a TPacketSource.
+ *
+ * @note `data` points into storage owned by the source and stays valid until the next call
+ *       to `TPacketSource::read()` on the same source.
+ */
+struct TPacket
+{
+	std::span<u8>              data;
+	TVidRender::WallTimePoint rxTime{};  // Kernel arrival time, default constructed if unknown
+};
+
+/**
+ * @brief Where TPacketFeeder pulls its datagrams from.
+ *
+ * Implementations are single consumer: `read()` is expected to be called from one thread only.
+ */
+class TPacketSource
+{
+  public:
+	using UniPtr = std::unique_ptr<TPacketSource>;
+
+	/**
+	 * @brief Fetch up to `out.size()` datagrams.
+	 * @return The number of datagrams written to `out`, 0 if nothing is available right now
+	 *         (or the source is exhausted, see `isExhausted()`), or a negated errno code on
+	 *         unrecoverable errors.
+	 */
+	virtual i32 read(std::span<TPacket> out) = 0;
+
+	/**
+	 * @brief Whether the source will never produce another datagram. Live sources never are.
+	 */
+	virtual bool isExhausted() const noexcept = 0;
+
+	virtual ~TPacketSource() = default;
+};
+
+/**
+ * @brief Live datagrams from a bound UDP socket, received in batches with recvmmsg().
+ *
+ * `read()` blocks until at least one datagram arrived or about 1 ms passed, so TPacketFeeder
+ * keeps its timers (slot scan, impaired datagram release) on time while idle. It does not
+ * replace TRecv; it exists to drive a TReassembly from a socket outside of TRecv, e.g. in
+ * benchmarks comparing the live path with the recorded ones.
+ */
+class TUdpPacketSource final : public TPacketSource
+{
+  public:
+	using UniPtr = std::unique_ptr<TUdpPacketSource>;
+
+	static constexpr u32 maxBatchSize = 256;
+
+  private:
+	struct Slot
+	{
+		alignas(cmsghdr) std::array<u8, CMSG_SPACE(sizeof(timespec))> ctrl;  // SCM_TIMESTAMPNS
+	};
+
+	int                fd = -1;
+	const bool         kernelTimestamps;
+	std::vector<u8>    packets;  // `maxDatagramLen` bytes per slot
+	std::vector<Slot>  slots;
+	std::vector<iovec> iovs;
+
+	std::vector<mmsghdr> msgs;
+
+  public:
+	i32  read(std::span<TPacket> out) override;
+	bool isExhausted() const noexcept override { return false; }
+
+	bool isBound() const noexcept { return fd > -1; }
+
+  public:
+	/**
+	 * @param batchSize Datagrams per recvmmsg() call, clamped to [1, maxBatchSize].
+	 * @param kernelTimestamps Request SO_TIMESTAMPNS for TPacket::rxTime.
+	 * @param maxDatagramLen Longer datagrams are truncated, match the `mtuLen` of the policy.
+	 * @note Failing to bind is logged and leaves the source unbound (`isBound()` returns false,
+	 *       `read()` returns -EBADF).
+	 */
+	TUdpPacketSource(
+		u16         port,
+		const char* ip,
+		u32         batchSize         = 32,
+		bool        _kernelTimestamps = true,
+		u32         maxDatagramLen    = MTU_LEN
+	);
+
+	[[nodiscard("Should not ignored the created TUdpPacketSource::UniPtr")]] static UniPtr create(
+		u16         port,
+		const char* ip,
+		u32         batchSize        = 32,
+		bool        kernelTimestamps = true,
+		u32         maxDatagramLen   = MTU_LEN
+	)
+	{
+		return std::make_unique<TUdpPacketSource>(
+			port, ip, batchSize, kernelTimestamps, maxDatagramLen
+		);
+	}
+
+	~TUdpPacketSource() override;
+
+	TUdpPacketSource(const TUdpPacketSource&)            = delete;
+	TUdpPacketSource& operator=(const TUdpPacketSource&) = delete;
+	TUdpPacketSource(TUdpPacketSource&&)                 = delete;
+	TUdpPacketSource& operator=(TUdpPacketSource&&)      = delete;
+};
+
+/**
+ * @brief Datagrams kept in memory, replayed as fast as they can be consumed.
+ *
+ * All datagrams live in a single contiguous buffer, so replaying them costs no more than
+ * reading that buffer once per pass. The set can be replayed several times (`setLoops()`);
+ * the frame indices are then shifted by the index span of the set on every pass, so the
+ * reassembler keeps seeing new frames instead of stale duplicates.
+ */
+class TMemPacketSource final : public TPacketSource
+{
+  public:
+	using UniPtr = std::unique_ptr<TMemPacketSource>;
+
+  private:
+	struct Entry
+	{
+		u64                        offset;
+		u32                        len;
+		u16                        frameIdx;   // As appended, before any per-pass shift
+		bool                       shiftable;  // Carries a valid protocol header
+		TVidRender::WallTimePoint rxTime;
+	};
+
+	std::vector<u8>    storage;
+	std::vector<Entry> entries;
+
+	u64  loops         = 1;
+	bool shiftFrameIdx = true;
+	u64  curLoop       = 0;
+	u64  cursor        = 0;
+
+	std::optional<u16> firstFrameIdx;       // Frame index of the first appended datagram
+	u16                frameIdxStride = 0;  // Frame indices covered by one pass
+
+  public:
+	/**
+	 * @brief Append a copy of `packet`. Packets without a valid protocol header are kept as is
+	 *        and never shifted.
+	 * @note Invalidates the spans handed out by `read()`.
+	 */
+	void append(std::span<const u8> packet, TVidRender::WallTimePoint rxTime = {});
+
+	/**
+	 * @brief Drain `source` until it is exhausted or `maxPackets` datagrams were copied.
+	 * @return The number of datagrams appended, or a negated errno code from `source`.
+	 * @note Live sources are never exhausted, bound them with `maxPackets`.
+	 */
+	i64 appendFrom(TPacketSource& source, u64 maxPackets = UINT64_MAX);
+
+	/**
+	 * @brief Replay the whole set `_loops` times (at least once). Rewinds the source.
+	 * @param _shiftFrameIdx Shift the frame indices on every pass after the first one.
+	 */
+	void setLoops(u64 _loops, bool _shiftFrameIdx = true) noexcept;
+
+	void rewind() noexcept;
+
+	u64 size() const noexcept { return entries.size(); }
+	u64 bytes() const noexcept { return storage.size(); }
+
+	i32  read(std::span<TPacket> out) override;
+	bool isExhausted() const noexcept override { return curLoop >= loops || entries.empty(); }
+
+  public:
+	TMemPacketSource() = default;
+
+	[[nodiscard("Should not ignored the created TMemPacketSource::UniPtr")]] static UniPtr create()
+	{
+		return std::make_unique<TMemPacketSource>();
+	}
+
+	~TMemPacketSource() override = default;
+};
+
+/**
+ * @brief Datagrams replayed from a capture file (see TCaptureFormat, recorded with
+ *        `TRecv::startCapture()`), either as fast as they can be consumed or at the pace they
+ *        were recorded.
+ *
+ * The file is memory mapped copy-on-write and `read()` hands out spans straight into the
+ * mapping, nothing is copied. A truncated trailing record (e.g. the recorder was killed) ends
+ * the replay early.
+ */
+class TCapturePacketSource final : public TPacketSource
+{
+  public:
+	using UniPtr    = std::unique_ptr<TCapturePacketSource>;
+	using TimePoint = std::chrono::steady_clock::time_point;
+
+	enum class Pacing : u8
+	{
+		FAST = 0,  // Hand out the datagrams as fast as they are read
+		RECORDED,  // Hold each datagram back until its recorded arrival offset has passed
+	};
+
+	// Longest a paced read() sleeps before returning empty-handed, so TPacketFeeder can still
+	// run the reassembly slot scan on time during recorded idle periods
+	static constexpr std::chrono::milliseconds maxPaceSleep{ 1 };
+
+  private:
+	u8* mapped  = nullptr;
+	u64 fileLen = 0;
+	u64 cursor  = 0;  // Offset of the next record
+
+	Pacing    pacing      = Pacing::FAST;
+	f64       speed       = 1.0;
+	TimePoint replayStart = TimePoint::min();  // Set by the first paced read() after a rewind
+
+  public:
+	i32  read(std::span<TPacket> out) override;
+	bool isExhausted() const noexcept override;
+
+	bool isOpen() const noexcept { return mapped != nullptr; }
+
+	void rewind() noexcept
+	{
+		cursor      = sizeof(TCaptureFormat::FileHeader);
+		replayStart = TimePoint::min();
+	}
+
+	/**
+	 * @brief Select how the datagrams are paced. Rewinds the source.
+	 * @param _speed Replay speed factor for Pacing::RECORDED, 2.0 replays twice as fast as
+	 *        recorded. Non-positive values are treated as 1.0.
+	 */
+	void setPacing(Pacing _pacing, f64 _speed = 1.0) noexcept
+	{
+		pacing = _pacing;
+		speed  = _speed > 0.0 ? _speed : 1.0;
+		rewind();
+	}
+
+  public:
+	/**
+	 * @note Failing to open, map or validate the file is logged and leaves the source closed
+	 *       (`isOpen()` returns false, `isExhausted()` returns true).
+	 */
+	explicit TCapturePacketSource(const std::string& path);
+
+	[[nodiscard("Should not ignored the created TCapturePacketSource::UniPtr")]] static UniPtr
+	create(const std::string& path)
+	{
+		return std::make_unique<TCapturePacketSource>(path);
+	}
+
+	~TCapturePacketSource() override;
+
+	TCapturePacketSource(const TCapturePacketSource&)            = delete;
+	TCapturePacketSource& operator=(const TCapturePacketSource&) = delete;
+	TCapturePacketSource(TCapturePacketSource&&)                 = delete;
+	TCapturePacketSource& operator=(TCapturePacketSource&&)      = delete;
+};
+
+/**
+ * @brief Feed a TReassembly from any TPacketSource on the calling thread, without TRecv.
+ *
+ * Besides handing the datagrams to `TReassembly::onPacketRecv()`, it runs the reassembly slot
+ * scan whenever `TReassembly::nextScanDeadline()` is due, exactly like the receiving thread of
+ * TRecv does. The reassembler must not be driven by a running TRecv at the same time.
+ *
+ * With `setImpairment()`, the datagrams go through a TImpairment first, so a capture can be
+ * replayed under the same seeded loss, reordering and jitter as many times as needed.
+ */
+template<typename Policy = TDefaultReAsmPolicy>
+class TBasicPacketFeeder
+{
+  public:
+	using SharedPtr      = std::shared_ptr<TBasicPacketFeeder>;
+	using UniPtr         = std::unique_ptr<TBasicPacketFeeder>;
+	using Reassembly     = TBasicReassembly<Policy>;
+	using ReassemblerPtr = typename Reassembly::SharedPtr;
+
+	static constexpr u32 batchSize = 64;
+
+	struct FeedStats
+	{
+		u64 packets = 0;
+		u64 bytes   = 0;
+		u64 reads   = 0;  // Calls to TPacketSource::read() that returned datagrams
+
+		std::chrono::nanoseconds elapsed{ 0 };
+
+		f64 packetsPerSec() const noexcept
+		{
+			if (elapsed.count() <= 0) { return 0.0; }
+			return static_cast<f64>(packets) * 1e9 / static_cast<f64>(elapsed.count());
+		}
+
+		f64 megabitsPerSec() const noexcept
+		{
+			if (elapsed.count() <= 0) { return 0.0; }
+			return static_cast<f64>(bytes) * 8e3 / static_cast<f64>(elapsed.count());
+		}
+	};
+
+  private:
+	const ReassemblerPtr reassembler;
+
+	std::unique_ptr<TImpairment> impairment;
+
+  private:
+	void deliver(const TPacket& packet);
+	void releaseImpaired(std::chrono::steady_clock::time_point now);
+
+	// Timer work, as in TRecv: release held impaired datagrams, then run the slot scan
+	void onTimerDue(std::chrono::steady_clock::time_point now);
+
+	// Earliest of the next slot scan and the next impaired datagram release
+	std::chrono::steady_clock::time_point nextTimerDeadline() const noexcept;
+
+  public:
+	/**
+	 * @brief Put an impairment stage in front of the reassembler, replacing the previous one.
+	 *        Options that impair nothing remove the stage.
+	 */
+	void setImpairment(const TImpairmentOptions& options);
+
+	/**
+	 * @return The impairment stage, nullptr if none is set.
+	 */
+	const TImpairment* getImpairment() const noexcept { return impairment.get(); }
+
+
+	/**
+	 * @brief Feed datagrams from `source` until it is exhausted, fails, `maxPackets` datagrams
+	 *        were fed, or a stop is requested on `sToken`.
+	 * @note Blocks the calling thread. A stop request is only noticed between two reads.
+	 *       Datagrams still held by the impairment stage when the source is exhausted are
+	 *       delivered at their release time before returning. `packets` and `bytes` count
+	 *       the datagrams read from the source.
+	 */
+	FeedStats feed(
+		TPacketSource& source, std::stop_token sToken = {}, u64 maxPackets = UINT64_MAX
+	);
+
+  public:
+	/**
+	 * @throw std::invalid_argument if the provided reassembler is nullptr.
+	 */
+	explicit TBasicPacketFeeder(ReassemblerPtr _reassembler);
+
+	[[nodiscard("Should not ignored the created TPacketFeeder::UniPtr")]] static UniPtr createUni(
+		ReassemblerPtr _reassembler
+	)
+	{
+		return std::make_unique<TBasicPacketFeeder>(std::move(_reassembler));
+	}
+
+	~TBasicPacketFeeder();
+
+	TBasicPacketFeeder(const TBasicPacketFeeder&)            = delete;
+	TBasicPacketFeeder& operator=(const TBasicPacketFeeder&) = delete;
+};
+
+using TPacketFeeder = TBasicPacketFeeder<>;
+
+// Instantiated in TPacketSource.cpp
+extern template class TBasicPacketFeeder<TDefaultReAsmPolicy>;
+extern template class TBasicPacketFeeder<TSmallMtuReAsmPolicy>;
+extern template class TBasicPacketFeeder<TJumboReAsmPolicy>;
+}  // namespace gentau
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "utils/TTypeRedef.hpp"
+
+#include <chrono>
+#include <concepts>
+
+namespace gentau {
+constexpr u64 MTU_LEN = 1400;  // 1400 B
+
+/**
+ * @brief 重组策略：TBasicReassembly、TBasicRecv 与 TBasicPacketFeeder 的编译期常量集合。
+ *
+ * 所有常量都是 static constexpr，位图、槽位数组与偏移计算都会针对具体策略在编译期展开，选择策略
+ * 不会带来任何运行期开销。自定义策略需要满足 TReAsmPolicy concept，并在 TReassembly.cpp、
+ * TRecv.cpp 与 TPacketSource.cpp 的末尾显式实例化。
+ *
+ *  - mtuLen:               单个 UDP 数据报（含 8 字节协议头部）的最大长度
+ *  - maxReAsmSlots:        同时重组的帧数上限
+ *  - maxSecPerFrame:       单帧的最大分片数，决定分片位图的大小。帧长受 TFramePool::slotLen 限制，
+ *                          因此不应超过一个槽位按最大负载切分所得的分片数
+ *  - bigFrameThres:        大于等于该长度的帧在槽位不足时最后被淘汰
+ *  - minFrameIdxDiff:      比上一次推送的帧旧这么多的帧被视为新会话的开始
+ *  - minFrameCompleteRate: 允许推送不完整帧时，超时帧至少需要收到的数据比例
+ *  - reassembleTimeout:    单帧的重组超时
+ *  - syncTimeout:          多久收不到有效包即视为失去同步
+ */
+template<typename P>
+concept TReAsmPolicy = requires {
+	{ P::mtuLen } -> std::convertible_to<u64>;
+	{ P::maxReAsmSlots } -> std::convertible_to<u32>;
+	{ P::maxSecPerFrame } -> std::convertible_to<u32>;
+	{ P::bigFrameThres } -> std::convertible_to<u32>;
+	{ P::minFrameIdxDiff } -> std::convertible_to<i16>;
+	{ P::minFrameCompleteRate } -> std::convertible_to<f32>;
+	{ P::reassembleTimeout } -> std::convertible_to<std::chrono::milliseconds>;
+	{ P::syncTimeout } -> std::convertible_to<std::chrono::milliseconds>;
+};
+
+/**
+ * @brief 默认策略，即赛场上手工调好的参数：1400 字节的数据报，720p / 1080p 码流。
+ */
+struct TDefaultReAsmPolicy
+{
+	static constexpr u64 mtuLen               = MTU_LEN;
+	static constexpr u32 maxReAsmSlots        = 5;
+	static constexpr u32 maxSecPerFrame       = 1507;   // 1507 * 1392 >= 2 MiB, a full frame slot
+	static constexpr u32 bigFrameThres        = 5000;   // 5 KB
+	static constexpr i16 minFrameIdxDiff      = -180;   // About 3 seconds, assuming 60 FPS
+	static constexpr f32 minFrameCompleteRate = 0.95f;  // Minimum receive data ratio to tolerate
+
+	// About 3.5 frames at 60 FPS
+	static constexpr std::chrono::milliseconds reassembleTimeout{ 60 };
+	static constexpr std::chrono::milliseconds syncTimeout{ 1000 };
+};
+
+/**
+ * @brief 720p 码流经过 MTU 较小（如隧道、VPN）的链路：1200 字节的数据报，帧更小、抖动更大。
+ */
+struct TSmallMtuReAsmPolicy
+{
+	static constexpr u64 mtuLen               = 1200;
+	static constexpr u32 maxReAsmSlots        = 8;      // More frames in flight on a jittery path
+	static constexpr u32 maxSecPerFrame       = 1024;   // 1024 * 1192 ~= 1.16 MiB
+	static constexpr u32 bigFrameThres        = 4000;   // 4 KB
+	static constexpr i16 minFrameIdxDiff      = -180;   // About 3 seconds, assuming 60 FPS
+	static constexpr f32 minFrameCompleteRate = 0.95f;  // Minimum receive data ratio to tolerate
+
+	static constexpr std::chrono::milliseconds reassembleTimeout{ 80 };
+	static constexpr std::chrono::milliseconds syncTimeout{ 1000 };
+};
+
+/**
+ * @brief 1080p 码流经过开启巨型帧的局域网：9000 字节 MTU 减去 IPv4 与 UDP 头部后为 8972 字节的
+ *        数据报，链路延迟低，超时可以更激进。
+ */
+struct TJumboReAsmPolicy
+{
+	static constexpr u64 mtuLen               = 8972;
+	static constexpr u32 maxReAsmSlots        = 5;
+	static constexpr u32 maxSecPerFrame       = 234;    // 234 * 8964 >= 2 MiB, a full frame slot
+	static constexpr u32 bigFrameThres        = 20000;  // 20 KB, a few datagrams
+	static constexpr i16 minFrameIdxDiff      = -180;   // About 3 seconds, assuming 60 FPS
+	static constexpr f32 minFrameCompleteRate = 0.95f;  // Minimum receive data ratio to tolerate
+
+	static constexpr std::chrono::milliseconds reassembleTimeout{ 40 };
+	static constexpr std::chrono::milliseconds syncTimeout{ 1000 };
+};
+}  // namespace gentau
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "utils/TTypeRedef.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+
+namespace gentau {
+/**
+ * @brief 重组统计的一份一致快照，由 TReAsmTelemetry::snapshot() 给出。
+ */
+struct TReAsmStats
+{
+	static constexpr u32 histBuckets = 16;
+
+	u64 completed        = 0;  // Frames whose sections all arrived
+	u64 pushedIncomplete = 0;  // Timed out frames pushed anyway (allowPushIncompleteFrames)
+	u64 evictedSmall     = 0;  // Dropped unfinished to make room for a newer frame
+	u64 evictedLarge     = 0;  // Same, frames of at least bigFrameThres bytes
+	u64 timedOut         = 0;  // Dropped unfinished by the reassembly timeout
+	u64 duplicateSecs    = 0;  // Sections received more than once
+	u64 stalePackets     = 0;  // Packets of frames not newer than the last pushed one
+	u64 resyncs          = 0;  // Sync regained after a sync timeout or a new session
+	u64 poolExhausted    = 0;  // Packets dropped for lack of a free TFramePool slot
+	u64 noReAsmSlot      = 0;  // Packets dropped, their table entry is kept by EvictPolicy
+
+	// First to last section time of the complete frames, bucket `b` counts the frames in
+	// [bucketFloor(b), bucketFloor(b + 1)), the last bucket is open ended
+	std::array<u64, histBuckets> asmTimeHist{};
+
+	static constexpr std::chrono::microseconds bucketFloor(u32 bucket) noexcept
+	{
+		return std::chrono::microseconds(bucket == 0 ? 0 : i64{ 8 } << bucket);
+	}
+
+	static constexpr u32 bucketOf(std::chrono::microseconds asmTime) noexcept
+	{
+		auto us = static_cast<u64>(std::max<i64>(asmTime.count(), 0));
+		return std::min<u32>(static_cast<u32>(std::bit_width(us >> 4)), histBuckets - 1);
+	}
+
+	u64 evicted() const noexcept { return evictedSmall + evictedLarge; }
+};
+
+/**
+ * @brief TBasicReassembly 的计数器与组装耗时直方图，单写者、多读者。
+ *
+ * 写者（接收线程）每次更新都用一个序列锁（seqlock）包裹，读者在序列号为奇数或前后不一致时
+ * 重读，因此快照中的所有计数器总是同一时刻的值。写者不会因为读者而等待或失败，读者也不持有
+ * 任何锁；所有字段都是 relaxed 原子变量，没有数据竞争。
+ *
+ * @note `add()` 与 `addCompleted()` 仅能在单一线程中调用，`snapshot()` 多线程安全。
+ */
+class TReAsmTelemetry
+{
+  public:
+	enum class Counter : u32
+	{
+		COMPLETED = 0,
+		PUSHED_INCOMPLETE,
+		EVICTED_SMALL,
+		EVICTED_LARGE,
+		TIMED_OUT,
+		DUPLICATE_SECS,
+		STALE_PACKETS,
+		RESYNCS,
+		POOL_EXHAUSTED,
+		NO_REASM_SLOT,
+		COUNT,
+	};
+
+  private:
+	static constexpr u32 counterCount = static_cast<u32>(Counter::COUNT);
+
+	alignas(64) std::atomic<u32> seq = 0;  // Odd while an update is in progress
+	std::array<std::atomic<u64>, counterCount + TReAsmStats::histBuckets> fields{};
+
+  private:
+	// Add `n` to each of `field`, all under one sequence number
+	template<typename... Field>
+	void bump(u64 n, Field... field) noexcept
+	{
+		auto s = seq.load(std::memory_order_relaxed);
+		seq.store(s + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		// Single writer, no read-modify-write needed
+		auto addTo = [n](std::atomic<u64>& value) {
+			value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+		};
+		(addTo(fields[field]), ...);
+
+		seq.store(s + 2, std::memory_order_release);
+	}
+
+  public:
+	void add(Counter counter, u64 n = 1) noexcept { bump(n, static_cast<u32>(counter)); }
+
+	// Count a complete frame together with its assembly time, so `completed` always equals
+	// the sum of `asmTimeHist` in a snapshot
+	void addCompleted(std::chrono::microseconds asmTime) noexcept
+	{
+		auto bucket = counterCount + TReAsmStats::bucketOf(asmTime);
+		bump(1, static_cast<u32>(Counter::COMPLETED), bucket);
+	}
+
+	TReAsmStats snapshot() const noexcept
+	{
+		std::array<u64, counterCount + TReAsmStats::histBuckets> values;
+
+		while (true) {
+			auto before = seq.load(std::memory_order_acquire);
+			if (before & 1) { continue; }  // An update is in progress
+
+			for (u32 i = 0; i < values.size(); i++) {
+				values[i] = fields[i].load(std::memory_order_relaxed);
+			}
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (seq.load(std::memory_order_relaxed) == before) { break; }
+		}
+
+		auto at = [&](Counter counter) { return values[static_cast<u32>(counter)]; };
+
+		TReAsmStats stats{ .completed        = at(Counter::COMPLETED),
+						   .pushedIncomplete = at(Counter::PUSHED_INCOMPLETE),
+						   .evictedSmall     = at(Counter::EVICTED_SMALL),
+						   .evictedLarge     = at(Counter::EVICTED_LARGE),
+						   .timedOut         = at(Counter::TIMED_OUT),
+						   .duplicateSecs    = at(Counter::DUPLICATE_SECS),
+						   .stalePackets     = at(Counter::STALE_PACKETS),
+						   .resyncs          = at(Counter::RESYNCS),
+						   .poolExhausted    = at(Counter::POOL_EXHAUSTED),
+						   .noReAsmSlot      = at(Counter::NO_REASM_SLOT) };
+
+		for (u32 b = 0; b < TReAsmStats::histBuckets; b++) {
+			stats.asmTimeHist[b] = values[counterCount + b];
+		}
+
+		return stats;
+	}
+};
+}  // namespace gentau
@@ -1,173 +1,409 @@
 #pragma once
 
+#include "img_trans/net/THevcNal.hpp"
+#include "img_trans/net/TReAsmPolicy.hpp"
+#include "img_trans/net/TReAsmTelemetry.hpp"
 #include "img_trans/vid_render/TFramePool.hpp"
 #include "img_trans/vid_render/TVidRender.hpp"
 
 #include "utils/TTypeRedef.hpp"
 
+#include <algorithm>
 #include <array>
 #include <atomic>
-#include <bitset>
+#include <bit>
 #include <chrono>
 #include <memory>
 #include <optional>
 #include <span>
+#include <utility>
 
 namespace gentau {
-constexpr u64 MTU_LEN = 1400;  // 1400 B
-
-class TRecv;
+template<typename Policy>
+class TBasicRecv;
+template<typename Policy>
+class TBasicPacketFeeder;
 
 class TRecvPasskey
 {
-	friend class TRecv;
+	template<typename Policy>
+	friend class TBasicRecv;
+
+	// Drives the reassembler from recorded or synthetic datagrams
+	template<typename Policy>
+	friend class TBasicPacketFeeder;
+
 	TRecvPasskey() = default;
 };
 
-class TReassembly : public std::enable_shared_from_this<TReassembly>
+/**
+ * @brief Header struct of the UDP packet according to the RM Comm. Protocol, the same for every
+ *        reassembly policy.
+ *
+ * @note Little-endian, size is 8 bytes, no alignment, might fail to construct on some
+ *       specific CPU archs.
+ * Ref: https://qingflow.com/appView/c5rf6rkkbs02/shareView/c5rf6slgbs02?applyId=693818572
+ */
+struct [[gnu::packed]] TPacketHeader
 {
-  public:
-	using SharedPtr = std::shared_ptr<TReassembly>;
-	using TimePoint = std::chrono::steady_clock::time_point;
+	u16 frameIdx;
+	u16 secIdx;
+	u32 frameLen;
 
-  public:
 	/**
-     * @brief Header struct of the UDP packet according to the RM Comm. Protocol 
-     *
-     * @note Little-endian, size is 8 bytes, no alignment, might fail to construct on some
-	 *       specific CPU archs.
-     * Ref: https://qingflow.com/appView/c5rf6rkkbs02/shareView/c5rf6slgbs02?applyId=693818572
-     */
-	struct [[gnu::packed]] Header
+	 * @brief Calculate the difference between two frame indices, considering wrap-around.
+	 * @return The signed difference between idx_a and idx_b. Positive if idx_a is after 
+	 *          idx_b, negative if idx_a is before idx_b, zero if they are the same.
+	 */
+	static constexpr i16 diff(u16 idx_a, u16 idx_b) noexcept
 	{
-		u16 frameIdx;
-		u16 secIdx;
-		u32 frameLen;
+		return static_cast<i16>(idx_a - idx_b);
+	}
 
-		/**
-		 * @brief Calculate the difference between two frame indices, considering wrap-around.
-		 * @return The signed difference between idx_a and idx_b. Positive if idx_a is after 
-		 *          idx_b, negative if idx_a is before idx_b, zero if they are the same.
-		 */
-		static constexpr i16 diff(u16 idx_a, u16 idx_b) noexcept
-		{
-			return static_cast<i16>(idx_a - idx_b);
-		}
+	/**
+	 * @brief Check if idx_a is after idx_b, considering wrap-around.
+	 */
+	static constexpr bool isAfter(u16 idx_a, u16 idx_b) noexcept
+	{
+		return diff(idx_a, idx_b) > 0;
+	}
 
-		/**
-		 * @brief Check if idx_a is after idx_b, considering wrap-around.
-		 */
-		static constexpr bool isAfter(u16 idx_a, u16 idx_b) noexcept
-		{
-			return diff(idx_a, idx_b) > 0;
-		}
+	/**
+	 * @brief Check if idx_a is before idx_b, considering wrap-around.
+	 */
+	static constexpr bool isBefore(u16 idx_a, u16 idx_b) noexcept
+	{
+		return diff(idx_a, idx_b) < 0;
+	}
 
-		/**
-		 * @brief Check if idx_a is before idx_b, considering wrap-around.
-		 */
-		static constexpr bool isBefore(u16 idx_a, u16 idx_b) noexcept
-		{
-			return diff(idx_a, idx_b) < 0;
-		}
+	/**
+	 * @brief Parse a raw buffer into a Header pointer.
+	 *
+	 * @param data The raw buffer to parse.
+	 * @return The parsed Header pointer, or nullptr if the buffer is too small.
+	 * @note No memory allocation or ownership transfer is performed.
+	 */
+	[[nodiscard("The parsed header pointer should not be ignored")]] static const TPacketHeader*
+	parse(std::span<const u8> data) noexcept
+	{
+		if (data.size() < sizeof(TPacketHeader)) { return nullptr; }
+		return reinterpret_cast<const TPacketHeader*>(data.data());
+	}
+};
+static_assert(sizeof(TPacketHeader) == 8, "Header size must be 8 bytes");
 
-		/**
-         * @brief Parse a raw buffer into a Header pointer.
-         *
-         * @param data The raw buffer to parse.
-         * @return The parsed Header pointer, or nullptr if the buffer is too small.
-         * @note No memory allocation or ownership transfer is performed.
-         */
-		[[nodiscard("The parsed header pointer should not be ignored")]] static const Header* parse(
-			std::span<const u8> data
-		) noexcept
-		{
-			if (data.size() < sizeof(Header)) { return nullptr; }
-			return reinterpret_cast<const Header*>(data.data());
-		}
-	};
-	static_assert(sizeof(Header) == 8, "Header size must be 8 bytes");
+/**
+ * @brief Verdict of TBasicReassembly::directFillTarget() on a peeked datagram.
+ */
+enum class TDirectFill : u8
+{
+	TARGET = 0,  // Admitted, receive the payload straight into the returned target
+	COPY,        // Admitted but no target (duplicate or odd length), take the copy path
+	DROP,        // Refused by admission (stale, out of range, no slot), discard the datagram
+};
+
+/**
+ * @brief 帧重组器，参数由编译期的重组策略 `Policy` 决定（参见 TReAsmPolicy）。通常使用默认策略
+ *        的别名 TReassembly 即可。
+ */
+template<typename Policy = TDefaultReAsmPolicy>
+class TBasicReassembly : public std::enable_shared_from_this<TBasicReassembly<Policy>>
+{
+	static_assert(TReAsmPolicy<Policy>, "Policy does not provide the reassembly constants");
+
+  public:
+	using SharedPtr     = std::shared_ptr<TBasicReassembly>;
+	using TimePoint     = std::chrono::steady_clock::time_point;
+	using WallTimePoint = TVidRender::WallTimePoint;
+	using RxTimestamps  = TVidRender::RxTimestamps;
+	using Header        = TPacketHeader;
+	using PolicyType    = Policy;
 
   public:
-	static constexpr u32 maxReAsmSlots        = 5;
-	static constexpr u32 maxPayloadSize       = MTU_LEN - sizeof(Header);
-	static constexpr u32 maxSecPerFrame       = 1536;   // 1536 = 64 * 24, 1536 * 1392 ~= 2.04 MiB
-	static constexpr u32 bigFrameThres        = 5000;   // 5 KB
-	static constexpr i16 minFrameIdxDiff      = -180;   // About 3 seconds, assuming 60 FPS
-	static constexpr f32 minFrameCompleteRate = 0.95f;  // Minimum receive data ratio to tolerate
+	static constexpr u64 mtuLen               = Policy::mtuLen;
+	static constexpr u32 maxReAsmSlots        = Policy::maxReAsmSlots;
+	static constexpr u32 maxPayloadSize       = mtuLen - sizeof(Header);
+	static constexpr u32 maxSecPerFrame       = Policy::maxSecPerFrame;
+	static constexpr u32 bigFrameThres        = Policy::bigFrameThres;
+	static constexpr i16 minFrameIdxDiff      = Policy::minFrameIdxDiff;
+	static constexpr f32 minFrameCompleteRate = Policy::minFrameCompleteRate;
+
+	static constexpr std::chrono::milliseconds reassembleTimeout = Policy::reassembleTimeout;
+	static constexpr std::chrono::milliseconds syncTimeout       = Policy::syncTimeout;
+
+	static_assert(mtuLen > sizeof(Header), "A datagram must have room for some payload");
+	static_assert(maxReAsmSlots > 0, "At least one frame must be reassembled at a time");
+	static_assert(maxSecPerFrame <= UINT16_MAX + 1u, "secIdx is an u16");
+	static_assert(
+		maxSecPerFrame <= (TFramePool::slotLen + maxPayloadSize - 1) / maxPayloadSize,
+		"Sections beyond a TFramePool slot can never be admitted"
+	);
+
+	// Entries of the direct-mapped slot table, frame `idx` can only live in entry
+	// `idx & (reAsmWindow - 1)`. Power of two, so the u16 frame index wraps onto it evenly.
+	static constexpr u32 reAsmWindow = std::bit_ceil(maxReAsmSlots);
+	static_assert(reAsmWindow <= 64, "The occupancy mask of the slot table is a single u64");
+
+	static constexpr u32 secWords = (maxSecPerFrame + 63) / 64;  // Words of the section bitmap
+
+	// Deepest jitter buffer, the held frames share TFramePool with the reassembly slots
+	static constexpr u32 maxJitterFrames = 4;
 
-	// About 3.5 frames at 60 FPS
-	static constexpr std::chrono::milliseconds reassembleTimeout{ 60 };
-	static constexpr std::chrono::milliseconds syncTimeout{ 1000 };
+	/**
+	 * @brief A run of consecutive sections of a frame, [first, first + count).
+	 */
+	struct SectionRange
+	{
+		u16 first = 0;
+		u16 count = 0;
+	};
+
+	/**
+	 * @brief Number of sections a frame of `frameLen` bytes is split into by the sender.
+	 */
+	static constexpr u32 sectionCount(u32 frameLen) noexcept
+	{
+		return static_cast<u32>((u64{ frameLen } + maxPayloadSize - 1) / maxPayloadSize);
+	}
+
+	/**
+	 * @brief State of the keyframe-gated recovery, see enableKeyframeRecovery().
+	 */
+	enum class RecoveryState : u8
+	{
+		NONE = 0,    // Every frame is pushed
+		AWAIT_IRAP,  // A frame was lost, frames are skipped until an IRAP frame arrives
+		SKIP_RASL,   // Recovered at an IRAP frame, its RASL frames are skipped still
+	};
 
   private:
 	struct ReassemblingFrame
 	{
-		std::optional<TFramePool::FrameData> frameSlot    = std::nullopt;
-		u16                                  frameIdx     = 0;
-		u32                                  curLen       = 0;
-		TimePoint                            asmStartTime = TimePoint::min();
-		std::bitset<maxSecPerFrame>          receivedSecs;  // bitmap is based on uint64_t array
+		TFramePool::FrameData     frameSlot{ nullptr, nullptr, UINT32_MAX };
+		u16                       frameIdx     = 0;  // Tag of the table entry
+		u32                       curLen       = 0;
+		u32                       expectedSecs = 0;  // sectionCount() of the frame length
+		u32                       recvSecs     = 0;
+		TimePoint                 asmStartTime = TimePoint::min();
+		RxTimestamps              rxTs;            // Kernel arrival of the sections
+		std::array<u64, secWords> receivedSecs{};  // Bit s % 64 of word s / 64: section s
 
 		void clear() noexcept
 		{
-			if (frameSlot.has_value()) { frameSlot.reset(); }
+			// Only sections below `expectedSecs` are ever set, leave the other words alone
+			std::fill_n(receivedSecs.begin(), (expectedSecs + 63) / 64, u64{ 0 });
+
+			frameSlot    = TFramePool::FrameData(nullptr, nullptr, UINT32_MAX);
 			frameIdx     = 0;
 			curLen       = 0;
+			expectedSecs = 0;
+			recvSecs     = 0;
 			asmStartTime = TimePoint::min();
-			receivedSecs.reset();
+			rxTs         = {};
+		}
+
+		bool hasSection(u32 secIdx) const noexcept
+		{
+			return (receivedSecs[secIdx / 64] >> (secIdx % 64)) & 1;
+		}
+
+		// Payload length of section `secIdx`, all of them are full except the last one
+		u32 sectionLen(u32 secIdx) const noexcept
+		{
+			return std::min(maxPayloadSize, frameSlot.getDataLen() - secIdx * maxPayloadSize);
 		}
 
+		/**
+		 * @return The first section at or after `from` that has (`received` true) or has not
+		 *         arrived yet, `expectedSecs` if there is none.
+		 */
+		u32 findSection(u32 from, bool received) const noexcept;
+
+		u32 missingCount() const noexcept { return expectedSecs - recvSecs; }
+
+		/**
+		 * @brief List the runs of sections that have not arrived, in ascending order.
+		 * @param out Filled with the first `out.size()` runs.
+		 * @return The total number of runs, which may be larger than `out.size()`.
+		 */
+		u32 missingRanges(std::span<SectionRange> out) const noexcept;
+
+		/**
+		 * @brief Length of the complete Annex-B NAL units in front of the first missing
+		 *        section, i.e. where an incomplete access unit can be cut into a valid one.
+		 * @return 0 if no slice (VCL NAL unit) is complete before the first missing section.
+		 */
+		u32 completeNalPrefix() const noexcept;
+
 		TFramePool::FrameData steal()
 		{
-			if (!frameSlot.has_value()) {
-				return TFramePool::FrameData(nullptr, nullptr, UINT32_MAX);
-			}
+			return std::exchange(frameSlot, TFramePool::FrameData(nullptr, nullptr, UINT32_MAX));
+		}
 
-			auto data = std::move(frameSlot).value();
-			frameSlot.reset();
+		bool isOccupied() const noexcept { return frameSlot.isValid(); }
 
-			return data;
+		bool isComplete() const noexcept
+		{
+			return frameSlot.isValid() && recvSecs == expectedSecs;
 		}
 
-		bool isOccupied() const noexcept
+		f32 getCompleteRate() const noexcept
 		{
-			if (!frameSlot.has_value()) { return false; }
+			if (!frameSlot.isValid() || curLen > frameSlot.getDataLen()) { return 0.0f; }
 
-			return frameSlot.value().isValid();
+			return static_cast<f32>(curLen) / static_cast<f32>(frameSlot.getDataLen());
 		}
 
-		bool isComplete() const noexcept
+		/**
+		 * @brief Resolve where the payload of section `secIdx` belongs in the frame slot.
+		 * @return The destination pointer, or nullptr if the section is duplicated, out of
+		 *         range, not of the length the frame length implies, or the slot is not ready
+		 *         to be filled.
+		 */
+		u8* fillTarget(u16 secIdx, u32 payloadSize) noexcept;
+
+		/**
+		 * @brief Mark section `secIdx` as received after its payload has been written to
+		 *        the address returned by `fillTarget()`.
+		 * @param rxTime Kernel arrival time of the section, default constructed if unknown.
+		 */
+		void markFilled(u16 secIdx, u32 payloadSize, WallTimePoint rxTime) noexcept
 		{
-			if (!frameSlot.has_value()) { return false; }
+			receivedSecs[secIdx / 64] |= u64{ 1 } << (secIdx % 64);
+			recvSecs++;
+			curLen += payloadSize;
 
-			if (!frameSlot.value().isValid()) { return false; }
+			if (rxTime == WallTimePoint{}) { return; }
 
-			return curLen == frameSlot.value().getDataLen();
+			// Sections may be reordered on the wire, so keep the earliest and the latest arrival
+			if (rxTs.first == WallTimePoint{} || rxTime < rxTs.first) { rxTs.first = rxTime; }
+			if (rxTime > rxTs.last) { rxTs.last = rxTime; }
 		}
 
-		f32 getCompleteRate() const noexcept
+		bool fill(std::span<u8> packet, const Header* header, WallTimePoint rxTime);
+	};
+
+	/**
+	 * @brief Decides which frame gives way when a new frame needs a table entry. Only consulted
+	 *        when a frame starts, never for the following sections of a known frame.
+	 */
+	struct EvictPolicy
+	{
+		/**
+		 * @brief The entry of frame `idx` holds another frame (same entry, different tag).
+		 * @return true if the occupant should be dropped for `idx`, false if the packet of
+		 *         `idx` should be dropped instead.
+		 */
+		static bool yieldsTo(const ReassemblingFrame& occupant, u16 idx) noexcept
 		{
-			if (!frameSlot.has_value()) { return 0.0f; }
+			// The two are a multiple of reAsmWindow apart, keep whichever is the newer frame
+			return Header::isBefore(occupant.frameIdx, idx);
+		}
 
-			if (!frameSlot.value().isValid()) { return 0.0f; }
+		/**
+		 * @brief `maxReAsmSlots` frames are being reassembled already, pick the one to drop:
+		 *        the oldest small frame, or the oldest large frame if there is no small one.
+		 * @param liveMask Bit `i` set if `table[i]` is occupied, must not be empty.
+		 * @return Position of the victim in `table`.
+		 */
+		static u32 pickVictim(
+			const std::array<ReassemblingFrame, reAsmWindow>& table, u64 liveMask
+		) noexcept;
+	};
 
-			if (curLen > frameSlot->getDataLen()) { return 0.0f; }
+	// The NAL units in front of the first slice of an access unit
+	struct AccessUnitInfo
+	{
+		u8  vclType  = THevcNal::unknown;  // nal_unit_type of the first slice
+		u32 insertAt = 0;                  // Where parameter sets can go: after the AUD, if any
 
-			return static_cast<f32>(curLen) / static_cast<f32>(frameSlot->getDataLen());
-		}
+		std::array<std::span<const u8>, 3> paramSets;  // VPS, SPS, PPS, start code included
+	};
+
+	static constexpr u32 maxParamSetLen = 1024;  // Longer parameter sets are not cached
+
+	// A finished frame waiting in the jitter buffer for the frames before it
+	struct HeldFrame
+	{
+		TFramePool::FrameData frame{ nullptr, nullptr, UINT32_MAX };
+		RxTimestamps          rxTs;
+		TimePoint             heldAt   = TimePoint::min();
+		u16                   frameIdx = 0;
+		bool                  complete = false;  // Not a timed out frame pushed incomplete
+	};
+
+	/**
+	 * @brief Rolling window of the section arrival spread (first to last section) of the
+	 *        complete frames and of the interval between frame starts, the adaptive reassembly
+	 *        timeout is derived from it, see enableAdaptiveTimeout().
+	 */
+	struct TimeoutEstimator
+	{
+		static constexpr u32 window      = 128;  // Frames in the rolling window
+		static constexpr u32 updateEvery = 16;   // Complete frames between two updates
+
+		static constexpr f32 spreadPercentile = 0.99f;
+		static constexpr f32 headroom         = 2.0f;  // Over the spread percentile
+
+		std::array<u32, window> spreadUs{};
+		std::array<u32, window> intervalUs{};
+		u32                     spreads   = 0;  // Samples taken, the window wraps on them
+		u32                     intervals = 0;
+		TimePoint               lastStart = TimePoint::min();
+
+		void addStart(TimePoint start) noexcept;
+		void addSpread(TimePoint::duration spread) noexcept;
+
+		bool isDue() const noexcept { return spreads >= updateEvery && spreads % updateEvery == 0; }
 
-		bool fill(std::span<u8> packet, const Header* header);
+		/**
+		 * @brief `headroom` times the spread percentile plus the median frame interval. The
+		 *        frames slower than the current timeout are never sampled, the headroom lets
+		 *        the timeout grow past them.
+		 */
+		TimePoint::duration estimate() const noexcept;
 	};
 
   private:
-	const TVidRender::SharedPtr                  renderer;
-	std::array<ReassemblingFrame, maxReAsmSlots> rFrames;
+	const TVidRender::SharedPtr                renderer;
+	std::array<ReassemblingFrame, reAsmWindow> rFrames;
+	u64                                        liveMask   = 0;  // Bit i: rFrames[i] occupied
+	ReassemblingFrame*                         directSlot = nullptr;
+
+	u16 lastHandledIdx = 0;  // Last frame pushed or skipped by the recovery gate
+	u32 skippedFrames  = 0;  // Skipped by the gate since the last loss
+
+	// Latest VPS / SPS / PPS seen in a complete frame, prepended to the first IRAP frame pushed
+	// after a resync or a decoder reset when that frame does not carry its own
+	std::array<std::array<u8, maxParamSetLen>, 3> paramSetCache{};
+	std::array<u32, 3>                             paramSetLens{};
+	bool                                           paramSetsDue  = true;
+	u64                                            decoderResets = 0;  // Last seen of renderer
+
+	TimeoutEstimator timeoutEstimator;
+
+	std::array<HeldFrame, maxJitterFrames + 1> heldFrames;  // Unordered, +1 for the overflow
+	u32                                        heldCount = 0;
+
+	TReAsmTelemetry telemetry;
 
   private:
 	std::atomic<TimePoint> lastSyncedTime      = TimePoint::min();
 	std::atomic<u16>       lastPushedIdx       = 0;
 	std::atomic<bool>      synced              = false;
 	std::atomic<bool>      allowPushIncomplete = false;
+	std::atomic<bool>      truncateIncomplete  = false;
+	std::atomic<bool>      keyframeRecovery    = false;
+
+	std::atomic<RecoveryState> recovery = RecoveryState::AWAIT_IRAP;
+
+	std::atomic<bool>                adaptiveTimeout = false;
+	std::atomic<TimePoint::duration> curTimeout{ reassembleTimeout };
+	std::atomic<TimePoint::duration> minTimeout{ std::chrono::milliseconds(10) };
+	std::atomic<TimePoint::duration> maxTimeout{ reassembleTimeout * 4 };
+
+	std::atomic<u32>                 jitterFrames = 0;  // 0: the jitter buffer is off
+	std::atomic<TimePoint::duration> jitterDelay{ TimePoint::duration::zero() };
 
   public:
 	/**
@@ -176,9 +412,15 @@ class TReassembly : public std::enable_shared_from_this<TReassembly>
 	 */
 	TimePoint getLastSyncedTime() const noexcept { return lastSyncedTime.load(); }
 
+	/**
+	 * @brief 获取重组计数器与组装耗时直方图的一致快照，参见 TReAsmStats。
+	 * @note 多线程安全且无锁，不会阻塞接收线程，适合由 UI 线程定期轮询。
+	 */
+	TReAsmStats getStats() const noexcept { return telemetry.snapshot(); }
+
 	/**
 	 * @brief 获取上一次推送到渲染管线的帧索引。若从未推送过任何帧，返回 0。
-	 * @note 多线程安全。
+	 * @note 多线程安全。被关键帧恢复跳过的帧同样视为已推送，比它更旧的帧不会再被推送。
 	 */
 	u16 getLastPushedIdx() const noexcept { return lastPushedIdx.load(); }
 
@@ -204,35 +446,281 @@ class TReassembly : public std::enable_shared_from_this<TReassembly>
 	 */
 	void allowPushIncompleteFrames(bool allow) noexcept { allowPushIncomplete.store(allow); }
 
+	/**
+	 * @brief 检查推送未完成的帧时是否按 NAL 边界截断。该设置默认为 false。
+	 * @note 多线程安全。
+	 */
+	bool incompleteTruncated() const noexcept { return truncateIncomplete.load(); }
+
+	/**
+	 * @brief 设置推送未完成的帧时是否按 NAL 边界截断。开启后不再推送带有空洞的整帧，而是在重组
+	 *        缓冲区中查找 Annex-B 起始码，只推送第一个缺失分片之前的完整 NAL 单元；若其中不含
+	 *        任何 slice（VCL NAL），则丢弃该帧。仅在 allowPushIncompleteFrames(true) 时生效。
+	 * @note 多线程安全。截断后的码流是合法的 H.265 码流，解码器只需对缺失的 slice 做错误隐藏，
+	 *       不会读到槽位中未初始化的内存，但缺失区域仍然可能出现花屏或残影。
+	 */
+	void truncateIncompleteFrames(bool truncate) noexcept { truncateIncomplete.store(truncate); }
+
+	/**
+	 * @brief 检查是否启用了关键帧恢复。该设置默认为 false。
+	 * @note 多线程安全。
+	 */
+	bool keyframeRecoveryEnabled() const noexcept { return keyframeRecovery.load(); }
+
+	/**
+	 * @brief 设置是否启用关键帧恢复。启用后，每当帧索引出现空洞（有帧丢失、超时或被丢弃）或重新
+	 *        同步时，不再推送非 IRAP 帧，直到收到下一个 IRAP 帧（IDR / CRA / BLA）为止；该 IRAP
+	 *        帧之后的 RASL 帧引用了丢失的帧，同样会被跳过。帧类型取自接入单元中第一个 slice 的
+	 *        NAL 单元类型；未截断的不完整帧的空洞中残留着旧数据，其类型不可信，一律视为
+	 *        非 IRAP 帧。
+	 * @note 多线程安全。丢帧后画面停留在最后一个正确的帧上，而不是花屏直到下一个关键帧，同时省去
+	 *       了解码器对这些无法正确解码的帧的开销。关键帧间隔较长的码流会因此出现较长的停顿。
+	 */
+	void enableKeyframeRecovery(bool enable) noexcept { keyframeRecovery.store(enable); }
+
+	/**
+	 * @brief 获取关键帧恢复的当前状态，未启用关键帧恢复时总是返回 RecoveryState::NONE。
+	 * @note 多线程安全。
+	 */
+	RecoveryState getRecoveryState() const noexcept
+	{
+		return keyframeRecoveryEnabled() ? recovery.load() : RecoveryState::NONE;
+	}
+
+	/**
+	 * @brief 检查是否启用了自适应重组超时。该设置默认为 false，此时重组超时固定为策略中的
+	 *        reassembleTimeout。
+	 * @note 多线程安全。
+	 */
+	bool adaptiveTimeoutEnabled() const noexcept { return adaptiveTimeout.load(); }
+
+	/**
+	 * @brief 设置是否启用自适应重组超时。启用后，根据最近 128 个完整帧的分片到达跨度（首个到最后
+	 *        一个分片）的 99 分位数的两倍，加上帧起始间隔的中位数，每 16 个完整帧更新一次重组
+	 *        超时，并限制在 setTimeoutBounds() 设置的范围内。干净的局域网上未完成的帧能更快被
+	 *        放弃，拥塞的链路上则不会丢弃即将完成的帧。关闭时恢复为 reassembleTimeout。
+	 * @note 多线程安全。
+	 */
+	void enableAdaptiveTimeout(bool enable) noexcept
+	{
+		adaptiveTimeout.store(enable);
+		if (!enable) { curTimeout.store(reassembleTimeout); }
+	}
+
+	/**
+	 * @brief 设置自适应重组超时的取值范围，默认为 [10 ms, 4 * reassembleTimeout]。
+	 * @return 若 lower 为 0 或大于 upper，返回 false 且不做任何修改。
+	 * @note 多线程安全。新的范围在下一次更新超时时生效。
+	 */
+	bool setTimeoutBounds(TimePoint::duration lower, TimePoint::duration upper) noexcept
+	{
+		if (lower <= TimePoint::duration::zero() || lower > upper) { return false; }
+
+		minTimeout.store(lower);
+		maxTimeout.store(upper);
+		return true;
+	}
+
+	/**
+	 * @brief 获取当前使用的重组超时。未启用自适应重组超时时即为 reassembleTimeout。
+	 * @note 多线程安全。
+	 */
+	TimePoint::duration getReassembleTimeout() const noexcept { return curTimeout.load(); }
+
+	/**
+	 * @brief 设置重排抖动缓冲。开启后，已完成的帧不再立即推送，而是先缓存起来并按帧索引顺序
+	 *        推送：紧接上一次推送的帧会立即推送；否则等待缺失的前序帧，直到缓存的帧数超过
+	 *        depthFrames，或最早缓存的帧已等待 maxDelay 为止，此时放弃缺失的帧。
+	 * @param depthFrames 最多缓存的帧数，0 表示关闭抖动缓冲（默认），不能超过 maxJitterFrames。
+	 * @param maxDelay 帧在缓冲中的最长等待时间，开启时必须大于 0。
+	 * @return 参数不合法时返回 false 且不做任何修改。
+	 * @note 多线程安全。以最多 maxDelay 的延迟为代价，换取乱序到达时更少的丢帧：没有抖动缓冲时，
+	 *       帧 N 的某个分片稍晚到达，只要帧 N + 1 先完成，帧 N 就会被丢弃。缓存的帧与重组槽位
+	 *       共用 TFramePool 的槽位。
+	 */
+	bool setJitterBuffer(u32 depthFrames, TimePoint::duration maxDelay) noexcept
+	{
+		if (depthFrames > maxJitterFrames) { return false; }
+		if (depthFrames > 0 && maxDelay <= TimePoint::duration::zero()) { return false; }
+
+		jitterDelay.store(maxDelay);
+		jitterFrames.store(depthFrames);
+		return true;
+	}
+
+	/**
+	 * @brief 获取重排抖动缓冲的深度（帧数），0 表示未开启。
+	 * @note 多线程安全。
+	 */
+	u32 getJitterBufferDepth() const noexcept { return jitterFrames.load(); }
+
   public:
 	/**
 	 * @brief 处理接收到的原始数据包。
 	 * @param packetData 接收到的包含协议头部的原始数据包内容，除此之外不能包含任何额外的填充字节。
-	 * @note 该方法仅能在 TRecv 类内部被正常调用，其他地方调用此方法将导致编译错误。该方法当且仅当
-	 *       存在单一调用者时才是线程安全的，请勿在多个线程中并发调用此方法。
+	 * @param rxTime 该数据包的内核接收时间戳（SO_TIMESTAMPNS），未知时传入默认构造的时间点。
+	 * @note 该方法仅能在 TRecv 或 TPacketFeeder 类内部被正常调用，其他地方调用此方法将导致编译
+	 *       错误。该方法当且仅当存在单一调用者时才是线程安全的，请勿在多个线程中并发调用此方法。
+	 */
+	void onPacketRecv(std::span<u8> packetData, WallTimePoint rxTime, TRecvPasskey);
+
+	/**
+	 * @brief 零拷贝接收的第一步：根据已窥视（MSG_PEEK）到的协议头部，为该分片解析出其在帧槽位中
+	 *        的目标地址，调用者随后应当将负载直接接收到返回的内存区域中，并调用 
+	 *        commitDirectFill() 提交。
+	 * @param header 窥视到的协议头部。
+	 * @param payloadSize 该数据包中负载（不含头部）的字节数。
+	 * @param dest 返回 TDirectFill::TARGET 时，被设为负载的目标内存区域，长度恰好为 payloadSize；
+	 *             否则被设为空 span。
+	 * @return TARGET 表示应当直接接收到 dest 中；COPY 表示该分片已被接纳但无法直接填充（重复
+	 *         分片或长度不符），调用者应当退回到 onPacketRecv() 的拷贝路径；DROP 表示该分片已被
+	 *         接纳检查拒绝（过期帧、越界或无法分配槽位），调用者应当直接丢弃该数据包，不得再交给
+	 *         onPacketRecv()，以免重复计数。
+	 * @note 仅能在 TRecv 类内部被正常调用。该方法当且仅当存在单一调用者时才是线程安全的，且必
+	 *       须与 onPacketRecv()、ReAsmSlotScan() 在同一线程中调用。
+	 */
+	TDirectFill directFillTarget(
+		const Header& header, u32 payloadSize, std::span<u8>& dest, TRecvPasskey
+	);
+
+	/**
+	 * @brief 零拷贝接收的第二步：提交已经直接写入 directFillTarget() 所返回区域的负载。
+	 * @param header 实际接收到的协议头部，必须与传入 directFillTarget() 的头部一致。
+	 * @param payloadSize 实际写入的负载字节数，必须与传入 directFillTarget() 的值一致。
+	 * @param rxTime 该数据包的内核接收时间戳，未知时传入默认构造的时间点。
+	 * @note 仅能在 TRecv 类内部被正常调用。在 directFillTarget() 未返回 TARGET 时调用此方法，或
+	 *       参数与上一次 directFillTarget() 不一致时，此方法不做任何事。
 	 */
-	void onPacketRecv(std::span<u8> packetData, TRecvPasskey);
+	void commitDirectFill(
+		const Header& header, u32 payloadSize, WallTimePoint rxTime, TRecvPasskey
+	);
 
 	/**
 	 * @brief 检查同步状态。扫描当前正在重组的帧，检查是否有重组超时的帧，并进行相应的处理。
-	 * @note 该方法仅能在 TRecv 类内部被正常调用，其他地方调用此方法将导致编译错误。该方法当且仅当
-	 *       存在单一调用者时才是线程安全的，请勿在多个线程中并发调用此方法。
+	 * @note 该方法仅能在 TRecv 或 TPacketFeeder 类内部被正常调用，其他地方调用此方法将导致编译
+	 *       错误。该方法当且仅当存在单一调用者时才是线程安全的，请勿在多个线程中并发调用此方法。
 	 */
 	void ReAsmSlotScan(TRecvPasskey);
 
+	/**
+	 * @brief 获取下一次需要调用 ReAsmSlotScan() 的时间点，即正在重组的帧中最早的重组超时时间点与
+	 *        同步超时时间点中较早的一个。若没有任何需要等待的超时，返回 TimePoint::max()。
+	 * @note 该方法仅能在 TRecv 或 TPacketFeeder 类内部被正常调用，且必须与 onPacketRecv()、
+	 *       ReAsmSlotScan() 在同一线程中调用。接收线程据此设置定时器，从而精确地在超时发生时
+	 *       扫描，且在链路空闲时不会被无意义地唤醒。
+	 */
+	TimePoint nextScanDeadline(TRecvPasskey) const noexcept;
+
+	/**
+	 * @brief 获取重排抖动缓冲中正在等待的帧数。
+	 * @note 该方法仅能在 TRecv 或 TPacketFeeder 类内部被正常调用，且必须与 onPacketRecv()、
+	 *       ReAsmSlotScan() 在同一线程中调用。
+	 */
+	u32 heldFrameCount(TRecvPasskey) const noexcept { return heldCount; }
+
   private:
+	static constexpr u32 slotPos(u16 frameIdx) noexcept { return frameIdx & (reAsmWindow - 1); }
+
+	/**
+	 * @brief Look up the table entry of `frameIdx`, O(1) for a frame being reassembled. Nothing
+	 *        is evicted here, see claimReAsmSlot().
+	 * @return The entry, possibly still holding an older frame that EvictPolicy lets the new
+	 *         frame replace, or nullptr if the packet should be dropped.
+	 */
 	ReassemblingFrame* findReAsmSlot(u16 frameIdx);
 
+	// Free the entry of new frame `frameIdx`, and the oldest frame if the table is full, once
+	// the frame slot of the new frame has been acquired
+	void claimReAsmSlot(u16 frameIdx);
+
+	// Return the frame slot of entry `pos` to the pool and mark the entry free
+	void releaseReAsmSlot(u32 pos) noexcept
+	{
+		rFrames[pos].clear();
+		liveMask &= ~(u64{ 1 } << pos);
+	}
+
+	// Count an unfinished frame dropped to make room for a newer one
+	void countEviction(const ReassemblingFrame& frame) noexcept
+	{
+		telemetry.add(
+			frame.frameSlot.getDataLen() >= bigFrameThres ? TReAsmTelemetry::Counter::EVICTED_LARGE
+														  : TReAsmTelemetry::Counter::EVICTED_SMALL
+		);
+	}
+
+	/**
+	 * @brief Run the sync / staleness checks for a packet and find (or start) the reassembly
+	 *        slot of its frame.
+	 * @return The slot the packet should be filled into, or nullptr if the packet should be
+	 *         dropped.
+	 */
+	ReassemblingFrame* admitPacket(const Header* header);
+
+	// Sample the arrival spread of a complete frame, adapt the reassembly timeout when due
+	void updateTimeout(TimePoint::duration spread) noexcept;
+
+	// Push the frame in `rSlot` to the renderer if all its sections have arrived.
+	void pushIfComplete(ReassemblingFrame* rSlot);
+
+	// Hand a finished frame to the jitter buffer, or straight to deliverFrame() if it is off
+	void pushFrame(u16 frameIdx, TFramePool::FrameData&& frame, RxTimestamps rxTs, bool complete);
+
+	// Push a frame to the renderer, in index order
+	void deliverFrame(
+		u16 frameIdx, TFramePool::FrameData&& frame, RxTimestamps rxTs, bool complete
+	);
+
+	// Deliver the held frames that are next in order, or whose wait is over
+	void releaseHeld(TimePoint now);
+
+	// Whether frame `frameIdx` is finished and waiting in the jitter buffer
+	bool isHeld(u16 frameIdx) const noexcept
+	{
+		for (u32 i = 0; i < heldCount; i++) {
+			if (heldFrames[i].frameIdx == frameIdx) { return true; }
+		}
+		return false;
+	}
+
+	/**
+	 * @brief Last step before `frame` goes to the renderer: cache its parameter sets (if
+	 *        `complete`), run the recovery gate and prepend the cached parameter sets if due.
+	 *        An incomplete frame that was not truncated is taken as non-IRAP.
+	 * @return false if the frame has to be skipped.
+	 */
+	bool preparePush(u16 frameIdx, TFramePool::FrameData& frame, bool complete);
+
+	/**
+	 * @brief Keyframe-gated recovery: track the gaps in the frame indices and decide whether
+	 *        a frame whose first slice is of `vclType` is pushed, see enableKeyframeRecovery().
+	 * @param decoderReset The decoder dropped its references since the last frame.
+	 * @return false if the frame has to be skipped.
+	 */
+	bool passRecoveryGate(u16 frameIdx, u8 vclType, bool decoderReset);
+
+	// Walk the NAL units of `au` up to its first slice
+	static AccessUnitInfo inspectAccessUnit(std::span<const u8> au) noexcept;
+
+	void cacheParamSets(const AccessUnitInfo& info) noexcept;
+
+	// Insert the cached parameter sets `frame` lacks, keeping the VPS, SPS, PPS order. Returns
+	// false if no slot has room for them, so the next IRAP frame tries again.
+	bool injectParamSets(TFramePool::FrameData& frame, const AccessUnitInfo& info) noexcept;
+
+	// Log which sections of a timed out frame never arrived (debug level only)
+	void logMissing(const ReassemblingFrame& frame);
+
   public:
 	/**
-	 * @brief constructor of TReassembly.
+	 * @brief constructor of TBasicReassembly.
 	 * @throw std::invalid_argument if the provided TVidRender::SharedPtr is nullptr
 	 *        in Non-Debug build.
 	 */
-	explicit TReassembly(TVidRender::SharedPtr _renderer);
+	explicit TBasicReassembly(TVidRender::SharedPtr _renderer);
 
 	/**
-	 * @brief create a shared pointer to TReassembly instance. 
+	 * @brief create a shared pointer to TBasicReassembly instance. 
 	 * @throw std::invalid_argument if the provided TVidRender::SharedPtr is nullptr
 	 *        in Non-Debug build.
 	 */
@@ -240,14 +728,21 @@ class TReassembly : public std::enable_shared_from_this<TReassembly>
 		TVidRender::SharedPtr _renderer
 	)
 	{
-		return std::make_shared<TReassembly>(std::move(_renderer));
+		return std::make_shared<TBasicReassembly>(std::move(_renderer));
 	}
-	~TReassembly() = default;
+	~TBasicReassembly() = default;
 
-	TReassembly()                              = delete;  // Forbid default construction
-	TReassembly(const TReassembly&)            = delete;  // Forbid copy or move
-	TReassembly& operator=(const TReassembly&) = delete;
-	TReassembly(TReassembly&&)                 = delete;
-	TReassembly&& operator=(TReassembly&&)     = delete;
+	TBasicReassembly()                                   = delete;  // Forbid default construction
+	TBasicReassembly(const TBasicReassembly&)            = delete;  // Forbid copy or move
+	TBasicReassembly& operator=(const TBasicReassembly&) = delete;
+	TBasicReassembly(TBasicReassembly&&)                 = delete;
+	TBasicReassembly&& operator=(TBasicReassembly&&)     = delete;
 };
+
+using TReassembly = TBasicReassembly<>;
+
+// Instantiated in TReassembly.cpp
+extern template class TBasicReassembly<TDefaultReAsmPolicy>;
+extern template class TBasicReassembly<TSmallMtuReAsmPolicy>;
+extern template class TBasicReassembly<TJumboReAsmPolicy>;
 }  // namespace gentau
\ No newline at end of file
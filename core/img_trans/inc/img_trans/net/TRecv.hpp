@@ -1,8 +1,11 @@
 #pragma once
 
+#include "img_trans/net/TCapture.hpp"
+#include "img_trans/net/TImpairment.hpp"
 #include "img_trans/net/TReassembly.hpp"
 
 #include "utils/TSignal.hpp"
+#include "utils/TThreadPolicy.hpp"
 #include "utils/TTypeRedef.hpp"
 
 #include <arpa/inet.h>
@@ -14,16 +17,100 @@
 #include <atomic>
 #include <chrono>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <span>
+#include <stop_token>
+#include <string>
 #include <thread>
 
 namespace gentau {
-class TRecv
+/**
+ * @brief Receive backend used by the TRecv receiving thread.
+ */
+enum class TRecvBackend : u8
+{
+	CLASSIC = 0,  // One recv() syscall per datagram
+	BATCHED,      // Up to `TRecvOptions::batchSize` datagrams per recvmmsg() syscall
+	ZERO_COPY,    // Peek the header, then recvmsg() the payload straight into the frame slot
+	IO_URING,     // io_uring multishot recvmsg with a provided-buffer ring
+
+	// Note: ZERO_COPY trades the per-packet memcpy for an extra MSG_PEEK syscall. It only pays
+	// off when memory bandwidth, not syscall count, is the bottleneck of the receive core.
+	// BATCHED, ZERO_COPY and IO_URING are Linux only, other platforms fall back to CLASSIC.
+	// IO_URING also falls back to CLASSIC at runtime if the kernel lacks the needed features.
+};
+
+/**
+ * @brief Construction options of TRecv. The defaults keep the classic receive loop.
+ */
+struct TRecvOptions
+{
+	TRecvBackend backend       = TRecvBackend::CLASSIC;
+	u32          batchSize     = 16;   // Only used by BATCHED, clamped to [1, maxBatchSize]
+	u32          uringBufCount = 256;  // Only used by IO_URING, rounded up to a power of two
+
+	// Ask the kernel for per-datagram arrival times (SO_TIMESTAMPNS, Linux only). They are
+	// recorded per frame and attached to the GstBuffer pushed by TVidRender.
+	bool kernelTimestamps = true;
+
+	i32 recvBufferSize = 1 * 1024 * 1024;  // Initial SO_RCVBUF, 1MB
+
+	// If larger than `recvBufferSize`, SO_RCVBUF is doubled (up to this cap) each time the
+	// kernel reports dropped datagrams (SO_RXQ_OVFL, Linux only). 0 disables auto-tuning.
+	i32 recvBufferMax = 0;
+
+	TThreadPolicy threadPolicy;  // Applied by the receiving thread itself on start
+
+	// Seeded loss / reordering / duplication / jitter between the socket and the reassembler,
+	// for testing only. Disabled by default. ZERO_COPY falls back to its copy path when enabled.
+	TImpairmentOptions impairment;
+};
+
+/**
+ * @brief UDP receiver feeding a TBasicReassembly of the same reassembly policy, whose `mtuLen`
+ *        sizes the receive buffers. Usually the TRecv alias of the default policy is all that
+ *        is needed.
+ */
+template<typename Policy = TDefaultReAsmPolicy>
+class TBasicRecv
 {
   public:
-	using UniPtr    = std::unique_ptr<TRecv>;
-	using SharedPtr = std::shared_ptr<TRecv>;
-	using TimePoint = std::chrono::steady_clock::time_point;
+	using UniPtr         = std::unique_ptr<TBasicRecv>;
+	using SharedPtr      = std::shared_ptr<TBasicRecv>;
+	using TimePoint      = std::chrono::steady_clock::time_point;
+	using WallTimePoint  = TVidRender::WallTimePoint;
+	using Backend        = TRecvBackend;
+	using Options        = TRecvOptions;
+	using Reassembly     = TBasicReassembly<Policy>;
+	using ReassemblerPtr = typename Reassembly::SharedPtr;
+
+	static constexpr u64 mtuLen = Reassembly::mtuLen;
+
+	/**
+	 * @brief Snapshot of the receive syscall counters.
+	 */
+	struct RecvStats
+	{
+		u64 recvCalls = 0;  // Receive syscalls that returned at least one datagram
+		u64 datagrams = 0;  // Datagrams handed to the reassembler
+
+		u64 directFills = 0;  // Datagrams scattered straight into a frame slot (ZERO_COPY)
+
+		/**
+		 * @brief Average datagrams per receive syscall. Always 1 for CLASSIC and 0.5 for
+		 *        ZERO_COPY (the MSG_PEEK is counted), 0 if nothing has been received yet.
+		 *        For IO_URING, each io_uring_enter() that reaped datagrams counts as one call.
+		 */
+		f64 avgBatchFill() const noexcept
+		{
+			if (recvCalls == 0) { return 0.0; }
+			return static_cast<f64>(datagrams) / static_cast<f64>(recvCalls);
+		}
+	};
+
+	static constexpr u32 maxBatchSize     = 256;
+	static constexpr u32 maxUringBufCount = 4096;
 
 	struct V4Addr
 	{
@@ -38,7 +125,7 @@ class TRecv
 		{
 			if (!isValid()) { return "Invalid IP"; }
 
-			auto ipStrOpt = TRecv::V4Addr::ipToStr(ip);
+			auto ipStrOpt = ipToStr(ip);
 			if (!ipStrOpt.has_value()) { return "Invalid IP"; }
 			return std::move(ipStrOpt).value() + ":" + std::to_string(port);
 		}
@@ -102,29 +189,125 @@ class TRecv
 	};
 
   private:
-	const TReassembly::SharedPtr reassembler;
-	UdpSocket                    updSock      = -1;
-	sockaddr_in                  listenAddr   = {};
-	std::atomic<TimePoint>       lastRecvTime = TimePoint::min();
+	const ReassemblerPtr   reassembler;
+	const Options          options;
+	UdpSocket              updSock      = -1;
+	sockaddr_in            listenAddr   = {};
+	std::atomic<TimePoint> lastRecvTime = TimePoint::min();
+
+	std::atomic<Backend> activeBackend = Backend::CLASSIC;
+
+	std::atomic<u64> recvCalls     = 0;
+	std::atomic<u64> recvDatagrams = 0;
+	std::atomic<u64> directFills   = 0;
+
+	std::atomic<u64> kernelDrops    = 0;
+	std::atomic<i32> recvBufferSize = 0;  // Current SO_RCVBUF granted by the kernel, not doubled
+
+	// Receiving thread only
+	u32       lastDropCounter = 0;  // Last SO_RXQ_OVFL counter, it wraps around at 2^32
+	TimePoint lastBufferGrow  = TimePoint::min();
+	bool      bufferCapped    = false;  // Growth stopped, reached the cap or net.core.rmem_max
+
+	TImpairment::UniPtr impairment;  // Only set if `Options::impairment` is enabled
+
+	// Capture recording, the receiving thread only takes the lock while `capturing` is set
+	std::mutex               captureMutex;
+	TCaptureRecorder::UniPtr recorder;
+	std::atomic<bool>        capturing = false;
 
   public:
-	TSignal<TRecv, i32> onRecvError;  // Passing errno code generated by recv() failure
+	TSignal<TBasicRecv, i32> onRecvError;  // Passing errno code generated by recv() failure
 
   private:
-	static constexpr i32     kRecvBufferSize = 1 * 1024 * 1024;  // 1MB
-	static constexpr timeval kRecvTimeout    = { 0, 50'000 };    // 50ms
+	static constexpr timeval kRecvTimeout = { 0, 50'000 };  // 50ms, non-Linux wake up only
 
   private:
 	// 这里必须放在所有字段的后面，以确保在析构时先停止线程，避免访问已销毁的成员变量。
 	std::jthread recvThread;
 
+  private:
+	/**
+	 * @brief Handle a failed receive syscall.
+	 * @return true if the receiving loop should keep running, false if it should stop.
+	 */
+	bool handleRecvError(i32 err, i32& enomemCount);
+
+	/**
+	 * @brief Parse the ancillary data of a received datagram: account the SO_RXQ_OVFL drop
+	 *        counter (growing the receive buffer if auto-tuning is on).
+	 * @return The SCM_TIMESTAMPNS kernel arrival time, default constructed if absent.
+	 */
+	WallTimePoint handleCtrlMsg(msghdr& msg) noexcept;
+
+	// Double SO_RCVBUF up to `Options::recvBufferMax` after the kernel dropped datagrams.
+	void growRecvBuffer() noexcept;
+
+	/**
+	 * @brief Append a received datagram to the capture file, if a capture is running. The
+	 *        datagram is given either whole in `head`, or split in protocol header and payload.
+	 */
+	void recordPacket(
+		std::span<const u8> head, std::span<const u8> payload, WallTimePoint rxTime
+	);
+
+	// Record the datagram if needed, then hand it to the reassembler (through the impairment
+	// stage if enabled). The capture holds what came off the wire, before any impairment.
+	void dispatchPacket(std::span<u8> packet, WallTimePoint rxTime)
+	{
+		recordPacket(packet, {}, rxTime);
+
+		if (impairment) [[unlikely]] {
+			impairPacket(packet, rxTime);
+			return;
+		}
+
+		reassembler->onPacketRecv(packet, rxTime, {});
+	}
+
+	void impairPacket(std::span<u8> packet, WallTimePoint rxTime);
+
+	// Hand the held datagrams whose release time passed to the reassembler.
+	void releaseImpaired(TimePoint now);
+
+	/**
+	 * @brief Work due on the receive thread timer: release held impaired datagrams, then run
+	 *        the reassembly slot scan.
+	 */
+	void onTimerDue();
+
+	/**
+	 * @return When onTimerDue() has to run next, the earlier of the reassembly deadline and the
+	 *         release of the next held impaired datagram.
+	 */
+	TimePoint nextTimerDeadline() const noexcept;
+
+	/**
+	 * @brief Event loop shared by the CLASSIC, BATCHED and ZERO_COPY backends. On Linux it
+	 *        sleeps in epoll until the socket is readable, the reassembly scan timer (a
+	 *        timerfd armed at TReassembly::nextScanDeadline()) expired or a stop is requested
+	 *        (an eventfd), then calls `recvOnce()` until the socket is drained.
+	 */
+	template<typename RecvFn>
+	void runRecvLoop(std::stop_token sToken, RecvFn&& recvOnce);
+
+	void recvLoopClassic(std::stop_token sToken);
+	void recvLoopBatched(std::stop_token sToken);
+	void recvLoopZeroCopy(std::stop_token sToken);
+
+	/**
+	 * @return false if io_uring could not be set up on this kernel and the caller should fall
+	 *         back to the classic loop, true once the loop has stopped normally.
+	 */
+	bool recvLoopUring(std::stop_token sToken);
+
   public:
 	/**
 	 * @brief Start the receiving thread.
 	 * @return 0 on success, else the POSIX errno code of the failure reason.
 	 *          - `EBADF` if the socket is not bound.
 	 *          - other errno codes from setsockopt() failure.
-	 * @note Recieving thread will be abnormally stopped when these recv() 
+	 * @note Recieving thread will be abnormally stopped when these recv() / recvmmsg()
 	 *       failures happened:
 	 *       - `EBADF` / `EFAULT` / `EINVAL` (FATAL error, will not retry)
 	 *       - `ENOMEM` (if it was triggered 5 times continuously) 
@@ -156,6 +339,83 @@ class TRecv
 	 */
 	TimePoint getLastRecvTime() const noexcept { return lastRecvTime.load(); }
 
+	/**
+	 * @brief Get the receive syscall counters accumulated since construction. Use
+	 *        `RecvStats::avgBatchFill()` to see how many datagrams each syscall carried.
+	 *
+	 * @note MT-SAFE
+	 */
+	RecvStats getRecvStats() const noexcept
+	{
+		return RecvStats{ .recvCalls   = recvCalls.load(std::memory_order_relaxed),
+						  .datagrams   = recvDatagrams.load(std::memory_order_relaxed),
+						  .directFills = directFills.load(std::memory_order_relaxed) };
+	}
+
+	/**
+	 * @brief Get the receive backend selected at construction time.
+	 * @note MT-SAFE
+	 */
+	Backend getBackend() const noexcept { return options.backend; }
+
+	/**
+	 * @brief Get the receive backend the receiving thread actually runs. It differs from
+	 *        getBackend() when the requested one is not available on this platform / kernel.
+	 * @note MT-SAFE
+	 */
+	Backend getActiveBackend() const noexcept { return activeBackend.load(); }
+
+	/**
+	 * @brief Get the number of datagrams the kernel dropped on this socket because the
+	 *        receive queue was full (SO_RXQ_OVFL). Drops are only reported along with the
+	 *        next datagram that makes it into the queue. Always 0 on non-Linux platforms.
+	 * @note MT-SAFE
+	 */
+	u64 getKernelDrops() const noexcept { return kernelDrops.load(std::memory_order_relaxed); }
+
+	/**
+	 * @brief Get the SO_RCVBUF size the kernel currently grants (not doubled), which may
+	 *        have been grown by auto-tuning or clamped by net.core.rmem_max. 0 if the
+	 *        receiving thread has not started yet.
+	 * @note MT-SAFE
+	 */
+	i32 getRecvBufferSize() const noexcept { return recvBufferSize.load(); }
+
+	/**
+	 * @brief Get the counters of the impairment stage, std::nullopt if it is disabled.
+	 * @note MT-SAFE
+	 */
+	std::optional<TImpairment::Stats> getImpairmentStats() const noexcept
+	{
+		if (!impairment) { return std::nullopt; }
+		return impairment->getStats();
+	}
+
+  public:
+	/**
+	 * @brief Start appending every received datagram, with its arrival time, to a capture
+	 *        file at `path` (see TCaptureFormat). A running capture is closed first. Replay
+	 *        the file with TCapturePacketSource and TPacketFeeder.
+	 *
+	 * @return 0 on success, else the POSIX errno code from creating or mapping the file.
+	 * @note MT-SAFE. May be called before or while the receiving thread runs. If writing the
+	 *       file fails later on (e.g. `ENOSPC`), the capture stops by itself and the error is
+	 *       logged.
+	 */
+	i32 startCapture(const std::string& path);
+
+	/**
+	 * @brief Stop the running capture, if any, and trim the capture file.
+	 * @return The number of datagrams recorded.
+	 * @note MT-SAFE
+	 */
+	u64 stopCapture();
+
+	/**
+	 * @note MT-SAFE
+	 */
+	bool isCapturing() const noexcept { return capturing.load(); }
+
   public:
 	/**
 	 * @brief Bind to a specific IPv4 address and port.
@@ -191,26 +451,34 @@ class TRecv
 	 * @param _reassembler A shared pointer to a TReassembly who is used for reassembling received packets.
 	 * @param _port The port to listen on.
 	 * @param _ip The IP address to bind to, only accept dotted-decimal notation.
+	 * @param _options Receive backend options, see TRecvOptions.
 	 * @throws std::invalid_argument if reassembler is nullptr in Non-Debug build.
 	 */
-	explicit TRecv(
-		TReassembly::SharedPtr _reassembler, u16 _port = 3334, const char* _ip = "127.0.0.1"
+	explicit TBasicRecv(
+		ReassemblerPtr _reassembler,
+		u16            _port    = 3334,
+		const char*    _ip      = "127.0.0.1",
+		Options        _options = {}
 	);
-	~TRecv();
+	~TBasicRecv();
 
 	/**
 	 * @brief create a unique pointer to TRecv instance. 
 	 * @param reassembler A shared pointer to a TReassembly who is used for reassembling received packets.
 	 * @param port The port to listen on.
 	 * @param ip The IP address to bind to, only accept dotted-decimal notation (e.g., "127.0.0.1").
+	 * @param options Receive backend options, see TRecvOptions.
 	 * @return A unique pointer to the created TRecv instance.
 	 * @throws std::invalid_argument if reassembler is nullptr in Non-Debug build.
 	 */
 	[[nodiscard("Should not ignored the created TRecv::UniPtr")]] static UniPtr createUni(
-		TReassembly::SharedPtr reassembler, u16 port = 3334, const char* ip = "127.0.0.1"
+		ReassemblerPtr reassembler,
+		u16            port    = 3334,
+		const char*    ip      = "127.0.0.1",
+		Options        options = {}
 	)
 	{
-		return std::make_unique<TRecv>(reassembler, port, ip);
+		return std::make_unique<TBasicRecv>(reassembler, port, ip, options);
 	}
 
 	/**
@@ -218,20 +486,31 @@ class TRecv
 	 * @param reassembler A shared pointer to a TReassembly who is used for reassembling received packets.
 	 * @param port The port to listen on.
 	 * @param ip The IP address to bind to, only accept dotted-decimal notation (e.g., "127.0.0.1").
+	 * @param options Receive backend options, see TRecvOptions.
 	 * @return A shared pointer to the created TRecv instance.
 	 * @throws std::invalid_argument if reassembler is nullptr in Non-Debug build.
 	 */
 	[[nodiscard("Should not ignored the created TRecv::SharedPtr")]] static SharedPtr createShared(
-		TReassembly::SharedPtr reassembler, u16 port = 3334, const char* ip = "127.0.0.1"
+		ReassemblerPtr reassembler,
+		u16            port    = 3334,
+		const char*    ip      = "127.0.0.1",
+		Options        options = {}
 	)
 	{
-		return std::make_shared<TRecv>(reassembler, port, ip);
+		return std::make_shared<TBasicRecv>(reassembler, port, ip, options);
 	}
 
-	TRecv()                        = delete;  // Forbid default construction
-	TRecv(const TRecv&)            = delete;  // Forbid copy or move
-	TRecv& operator=(const TRecv&) = delete;
-	TRecv(TRecv&&)                 = delete;
-	TRecv& operator=(TRecv&&)      = delete;
+	TBasicRecv()                             = delete;  // Forbid default construction
+	TBasicRecv(const TBasicRecv&)            = delete;  // Forbid copy or move
+	TBasicRecv& operator=(const TBasicRecv&) = delete;
+	TBasicRecv(TBasicRecv&&)                 = delete;
+	TBasicRecv& operator=(TBasicRecv&&)      = delete;
 };
+
+using TRecv = TBasicRecv<>;
+
+// Instantiated in TRecv.cpp
+extern template class TBasicRecv<TDefaultReAsmPolicy>;
+extern template class TBasicRecv<TSmallMtuReAsmPolicy>;
+extern template class TBasicRecv<TJumboReAsmPolicy>;
 }  // namespace gentau
\ No newline at end of file
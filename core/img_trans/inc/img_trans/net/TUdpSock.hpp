@@ -0,0 +1,68 @@
+#pragma once
+
+#include "utils/TTypeRedef.hpp"
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include <optional>
+
+namespace gentau {
+/**
+ * TUdpSock 汇集了 TRecv 与 TUdpPacketSource 共用的 UDP 套接字创建、绑定与选项设置，使两者对
+ * 内核行为（例如 net.core.rmem_max 对 SO_RCVBUF 的静默截断）的处理保持一致。
+ *
+ * 所有函数都不打印日志，失败时返回 POSIX errno，由调用者决定如何报告。
+ *
+ * @note 所有函数均为 MT-SAFE，但同一个套接字上的设置应当由同一个线程完成。
+ */
+struct TUdpSock
+{
+	static sockaddr_in makeV4Addr(u32 ipNetworkOrder, u16 port) noexcept
+	{
+		sockaddr_in addr{};
+		addr.sin_family      = AF_INET;
+		addr.sin_addr.s_addr = ipNetworkOrder;
+		addr.sin_port        = htons(port);
+		return addr;
+	}
+
+	/**
+	 * @brief Create an IPv4 UDP socket and bind it to `addr`.
+	 * @return The socket fd, or the negated POSIX errno code of the failure reason.
+	 */
+	static i32 bindV4(const sockaddr_in& addr) noexcept;
+
+	/**
+	 * @brief Set SO_RCVBUF to `size` bytes. SO_RCVBUFFORCE is tried first, it only works with
+	 *        CAP_NET_ADMIN but is then not limited by net.core.rmem_max.
+	 * @return 0 on success, else the POSIX errno code of the failure reason.
+	 * @note Success does not mean the size has been granted, see getRecvBuffer().
+	 */
+	static i32 setRecvBuffer(int sock, i32 size) noexcept;
+
+	/**
+	 * @brief Get the SO_RCVBUF size granted by the kernel, comparable with the requested one
+	 *        (Linux reports it doubled, bookkeeping included, this halves it back).
+	 */
+	static std::optional<i32> getRecvBuffer(int sock) noexcept;
+
+	/**
+	 * @return 0 on success, else the POSIX errno code of the failure reason.
+	 */
+	static i32 setRecvTimeout(int sock, timeval timeout) noexcept;
+
+	/**
+	 * @brief Request per-datagram kernel arrival times (SO_TIMESTAMPNS).
+	 * @return 0 on success, ENOTSUP where SO_TIMESTAMPNS does not exist, else the errno.
+	 */
+	static i32 enableTimestamps(int sock) noexcept;
+
+	/**
+	 * @brief Request the kernel drop counter along with each datagram (SO_RXQ_OVFL).
+	 * @return 0 on success, ENOTSUP where SO_RXQ_OVFL does not exist, else the errno.
+	 */
+	static i32 enableDropCounter(int sock) noexcept;
+};
+}  // namespace gentau
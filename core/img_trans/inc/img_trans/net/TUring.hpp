@@ -0,0 +1,164 @@
+#pragma once
+
+#ifdef __linux__
+
+#include "utils/TTypeRedef.hpp"
+
+#include <linux/io_uring.h>
+
+#include <cstddef>
+#include <span>
+
+namespace gentau {
+/**
+ * TUring 是 io_uring 的最小化封装，直接使用 io_uring_setup / io_uring_enter / io_uring_register
+ * 系统调用实现，不依赖 liburing。它只提供 TRecv 的接收线程所需的功能：提交队列、完成队列与一个
+ * provided-buffer ring（由内核在 multishot 接收时自行挑选缓冲区）。
+ *
+ * TUring 不是线程安全的，其所有方法都必须在同一个线程中调用。
+ *
+ * 在使用前应当先调用 TUring::isSupported() 检查当前内核是否支持所需的特性（io_uring 本身、
+ * IORING_OP_RECVMSG 与 provided-buffer ring，即 Linux 5.19+）。multishot recvmsg 需要 Linux 6.0+，
+ * 该特性无法被 probe，调用者需要在首个完成事件返回 -EINVAL 时自行回退。
+ */
+class TUring
+{
+  public:
+	struct Completion
+	{
+		u64 userData = 0;
+		i32 res      = 0;
+		u32 flags    = 0;
+	};
+
+  private:
+	int ringFd = -1;
+
+	// Submission queue
+	void*         sqRingPtr = nullptr;
+	std::size_t   sqRingSz  = 0;
+	io_uring_sqe* sqes      = nullptr;
+	std::size_t   sqesSz    = 0;
+	u32*          sqHead    = nullptr;
+	u32*          sqTail    = nullptr;
+	u32*          sqMask    = nullptr;
+	u32*          sqArray   = nullptr;
+	u32           sqEntries = 0;
+	u32           sqPending = 0;  // SQEs filled but not yet submitted
+
+	// Completion queue
+	void*         cqRingPtr = nullptr;
+	std::size_t   cqRingSz  = 0;
+	u32*          cqHead    = nullptr;
+	u32*          cqTail    = nullptr;
+	u32*          cqMask    = nullptr;
+	io_uring_cqe* cqes      = nullptr;
+
+	// Provided buffer ring
+	io_uring_buf_ring* bufRing     = nullptr;
+	std::size_t        bufRingSz   = 0;
+	u8*                bufPool     = nullptr;
+	std::size_t        bufPoolSz   = 0;
+	u32                bufCount    = 0;
+	u32                bufLen      = 0;
+	u16                bufGroup    = 0;
+	u16                bufTail     = 0;  // Local tail, published by publishBuffers()
+	bool               bufRingRegd = false;
+
+  public:
+	/**
+	 * @brief Check (once per process) whether the running kernel provides io_uring with
+	 *        IORING_OP_RECVMSG, IORING_OP_READ and provided-buffer rings.
+	 * @note MT-SAFE
+	 */
+	static bool isSupported() noexcept;
+
+	/**
+	 * @brief Create the ring.
+	 * @return 0 on success, else the POSIX errno code of the failure reason.
+	 */
+	i32 init(u32 entries) noexcept;
+
+	/**
+	 * @brief Allocate `count` buffers of `len` bytes and register them as provided-buffer
+	 *        group `bgid`. `count` must be a power of two no larger than 32768.
+	 * @return 0 on success, else the POSIX errno code of the failure reason.
+	 */
+	i32 setupBufRing(u16 bgid, u32 count, u32 len) noexcept;
+
+	bool isValid() const noexcept { return ringFd > -1; }
+
+	/**
+	 * @brief Get a zeroed SQE to fill, or nullptr if the submission queue is full.
+	 */
+	io_uring_sqe* getSqe() noexcept;
+
+	/**
+	 * @brief Submit all pending SQEs and wait until at least `waitNr` completions are ready.
+	 * @return 0 on success, else the POSIX errno code of io_uring_enter().
+	 */
+	i32 submit(u32 waitNr = 0) noexcept;
+
+	/**
+	 * @brief Consume all ready completions, calling `fn(const Completion&)` on each.
+	 * @return The number of consumed completions.
+	 */
+	template<typename Fn>
+	u32 drainCompletions(Fn&& fn);
+
+	/**
+	 * @brief Get the provided buffer `bid` selected by the kernel for a completion.
+	 */
+	std::span<u8> buffer(u16 bid) noexcept
+	{
+		return { bufPool + static_cast<std::size_t>(bid) * bufLen, bufLen };
+	}
+
+	/**
+	 * @brief Give buffer `bid` back to the kernel. Takes effect after publishBuffers().
+	 */
+	void recycleBuffer(u16 bid) noexcept;
+
+	/**
+	 * @brief Publish all recycled buffers to the kernel.
+	 */
+	void publishBuffers() noexcept;
+
+	void release() noexcept;
+
+  public:
+	TUring() = default;
+	~TUring() { release(); }
+
+	TUring(const TUring&)            = delete;  // Forbid copy or move
+	TUring& operator=(const TUring&) = delete;
+	TUring(TUring&&)                 = delete;
+	TUring& operator=(TUring&&)      = delete;
+
+  private:
+	u32  loadAcquire(const u32* p) const noexcept;
+	void storeRelease(u32* p, u32 v) noexcept;
+};
+
+template<typename Fn>
+u32 TUring::drainCompletions(Fn&& fn)
+{
+	u32 head  = *cqHead;  // Only this thread writes the CQ head
+	u32 tail  = loadAcquire(cqTail);
+	u32 count = 0;
+
+	while (head != tail) {
+		const io_uring_cqe& cqe = cqes[head & *cqMask];
+		fn(Completion{ .userData = cqe.user_data, .res = cqe.res, .flags = cqe.flags });
+
+		head++;
+		count++;
+	}
+
+	if (count > 0) { storeRelease(cqHead, head); }
+
+	return count;
+}
+}  // namespace gentau
+
+#endif  // __linux__
@@ -2,33 +2,195 @@
 
 #include "utils/TTypeRedef.hpp"
 
-#include "readerwritercircularbuffer.h"
+#include <sys/mman.h>
 
 #include <array>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
 #include <cstdint>
 #include <cstring>
 #include <memory>
 #include <optional>
+#include <stdexcept>
+#include <string>
 
 namespace gentau {
+/**
+ * @brief TFramePool 的大小：每一级的初始槽位数与弹性增长的上限。上限等于初始值时池的大小固定。
+ */
+struct TFramePoolOptions
+{
+	using Counts = std::array<u32, 4>;  // One per size class, see TFramePool::slotLens
+
+	// 30 MiB in total, with the 10 slots of 2 MiB the fixed pool had for keyframe bursts
+	Counts slots    = { 128, 32, 8, 10 };
+	Counts maxSlots = { 128, 32, 8, 10 };  // Address space is reserved for these up front
+
+	// Slots grown beyond `slots` are retired once a whole period passes without needing them,
+	// zero keeps them
+	std::chrono::milliseconds shrinkAfter{ 10'000 };
+};
+
+/**
+ * @brief 按大小分级的帧缓冲池：每一级是一组等长的槽位，各自维护空闲列表。
+ *
+ * 取用时选择能容纳该帧的最小一级，该级耗尽时依次向更大的一级借用。小的 P 帧只占 16 KiB 的槽位，
+ * 在同样的内存里可以同时持有远多于固定 2 MiB 槽位时的帧，拷贝与解码时也更容易留在缓存中。
+ *
+ * 所有槽位位于一块匿名 mmap 区域中，只保留地址空间，物理页在槽位第一次被写入时才分配，
+ * 构造几乎没有开销，常驻内存随实际用到的槽位增长。可选地在归还大槽位时把它的页交还给内核，
+ * 参见 setReclaimThreshold()；也可以改用大页并锁定在内存中，参见 setPageMode() 与 setLocked()。
+ *
+ * 每一级的槽位数在构造时给出（见 TFramePoolOptions），并可以弹性增长：某一级耗尽时先在上限内启用新的
+ * 槽位，再向更大的一级借用；持续一段时间用不到增长出来的槽位后，多余的槽位被收回并交还物理页。
+ * getStats() 给出各级的峰值占用、取用失败次数与平均持有时长，用于按实际部署调整池的大小。
+ */
 class [[gnu::aligned(64)]] TFramePool
 {
   public:
-	static constexpr u32 poolSize = 10;
-	static constexpr u32 slotLen  = 2 * 1024 * 1024;  // 2 MiB per slot
+	// Ascending slot lengths of the size classes
+	static constexpr std::array<u32, 4> slotLens{
+		16 * 1024,        // P-frames
+		128 * 1024,       // Large P-frames, small keyframes
+		512 * 1024,       // Most keyframes
+		2 * 1024 * 1024,  // Anything up to the longest frame
+	};
 
-  public:
-	using SharedPtr   = std::shared_ptr<TFramePool>;
-	using Frame       = std::array<u8, slotLen>;
-	using Pool        = std::array<Frame, poolSize>;
-	using FreeIdxList = moodycamel::BlockingReaderWriterCircularBuffer<u32>;
+	static constexpr u32 classCount = slotLens.size();
+	static constexpr u32 slotLen    = slotLens.back();  // Longest frame it can hold
+
+	using Options = TFramePoolOptions;
+
+	static_assert(std::tuple_size_v<Options::Counts> == classCount, "One count per size class");
+
+	struct Stats
+	{
+		struct Class
+		{
+			u32 slotLen   = 0;
+			u32 slots     = 0;  // Current size, grows up to maxSlots
+			u32 maxSlots  = 0;
+			u32 inUse     = 0;
+			u32 highWater = 0;  // Most slots in use at once since construction
+		};
+
+		std::array<Class, classCount> classes{};
+
+		u32 inUse     = 0;
+		u32 highWater = 0;  // Over all classes at once, not the sum of the class peaks
+
+		u64 acquired = 0;
+		u64 failures = 0;  // No free slot large enough, even after growing
+		u64 grown    = 0;  // Slots brought in beyond the initial size
+		u64 shrunk   = 0;  // Slots retired after low use
+
+		std::chrono::microseconds avgHoldTime{ 0 };  // Acquire to restore, over all restores
+	};
+
+	enum class PageMode : u8
+	{
+		SMALL = 0,         // Base pages (4 KiB)
+		TRANSPARENT_HUGE,  // madvise(MADV_HUGEPAGE), the kernel backs it with 2 MiB pages if it can
+		EXPLICIT_HUGE,     // MAP_HUGETLB, needs free pages in /proc/sys/vm/nr_hugepages
+	};
+
+	using SharedPtr = std::shared_ptr<TFramePool>;
+
+	/**
+	 * @brief 槽位索引的无锁栈（Treiber stack），任意多个线程可以同时压入与弹出。
+	 *
+	 * 栈顶把索引与一个每次修改都递增的标签打包在同一个 64 位原子变量中，某个弹出者读取后、
+	 * 其他线程弹出再压回同一个槽位（ABA）时，标签已经变化，该弹出者的 CAS 会失败并重试。
+	 * 后进先出也让刚归还、仍在缓存中的槽位最先被复用。
+	 */
+	class FreeIdxList
+	{
+	  private:
+		static constexpr u32 nil = UINT32_MAX;
+
+		const u32 firstIdx;  // First slot index the list can hold
+
+		alignas(64) std::atomic<u64> head = pack(0, nil);
+		std::atomic<u32> count = 0;
+
+		std::unique_ptr<std::atomic<u32>[]> next;  // Link of each slot while it is in the list
+
+	  private:
+		static constexpr u64 pack(u32 tag, u32 idx) noexcept { return u64{ tag } << 32 | idx; }
+		static constexpr u32 tagOf(u64 word) noexcept { return static_cast<u32>(word >> 32); }
+		static constexpr u32 idxOf(u64 word) noexcept { return static_cast<u32>(word); }
+
+	  public:
+		void push(u32 idx) noexcept
+		{
+			auto top = head.load(std::memory_order_relaxed);
+			do {
+				next[idx - firstIdx].store(idxOf(top), std::memory_order_relaxed);
+			} while (!head.compare_exchange_weak(
+				top, pack(tagOf(top) + 1, idx), std::memory_order_release, std::memory_order_relaxed
+			));
+
+			count.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		bool pop(u32& idx) noexcept
+		{
+			auto top = head.load(std::memory_order_acquire);
+			while (idxOf(top) != nil) {
+				// May be stale if `top` was taken meanwhile, the tag then fails the CAS
+				auto below = next[idxOf(top) - firstIdx].load(std::memory_order_relaxed);
+
+				if (head.compare_exchange_weak(
+						top, pack(tagOf(top) + 1, below), std::memory_order_acquire
+					)) {
+					count.fetch_sub(1, std::memory_order_relaxed);
+					idx = idxOf(top);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		u32 sizeApprox() const noexcept { return count.load(std::memory_order_relaxed); }
+
+	  public:
+		FreeIdxList(u32 _firstIdx, u32 _capacity) :
+			firstIdx(_firstIdx),
+			next(std::make_unique<std::atomic<u32>[]>(_capacity))
+		{}
+
+		FreeIdxList(const FreeIdxList&)            = delete;
+		FreeIdxList& operator=(const FreeIdxList&) = delete;
+	};
+
+	// Smallest class whose slots hold `len` bytes, classCount if none does
+	static constexpr u32 classFor(u32 len) noexcept
+	{
+		u32 c = 0;
+		while (c < classCount && slotLens[c] < len) { c++; }
+		return c;
+	}
+
+	u32 classOf(u32 idx) const noexcept
+	{
+		u32 c = 0;
+		while (c + 1 < classCount && idx >= layout[c + 1].firstIdx) { c++; }
+		return c;
+	}
+
+	u32 slotCapacity(u32 idx) const noexcept
+	{
+		return idx < poolSize ? slotLens[classOf(idx)] : 0;
+	}
 
   public:
 	class FrameData
 	{
 	  private:
 		TFramePool* pool     = nullptr;
-		Frame*      frame    = nullptr;
+		u8*         frame    = nullptr;
 		u32         idx      = UINT32_MAX;
 		u32         frameLen = 0;
 
@@ -36,9 +198,15 @@ class [[gnu::aligned(64)]] TFramePool
 		u8* data() noexcept
 		{
 			if (!isValid()) { return nullptr; }
-			return frame->data();
+			return frame;
+		}
+		const u8* data() const noexcept
+		{
+			if (!isValid()) { return nullptr; }
+			return frame;
 		}
 		u32 index() const noexcept { return idx; }
+		u32 capacity() const noexcept { return isValid() ? pool->slotCapacity(idx) : 0; }
 
 		u32  getDataLen() const noexcept { return frameLen; }
 		void setDataLen(u32 len) noexcept { frameLen = len; }
@@ -46,11 +214,11 @@ class [[gnu::aligned(64)]] TFramePool
 	  public:
 		bool isValid() const noexcept
 		{
-			return pool != nullptr && frame != nullptr && idx < poolSize;
+			return pool != nullptr && frame != nullptr && idx < pool->poolSize;
 		}
 
 	  public:
-		FrameData(TFramePool* _pool, Frame* _frame, u32 _idx) :
+		FrameData(TFramePool* _pool, u8* _frame, u32 _idx) :
 			pool(_pool),
 			frame(_frame),
 			idx(_idx) {};
@@ -95,38 +263,376 @@ class [[gnu::aligned(64)]] TFramePool
 	};
 
   private:
-	Pool        poolData;
-	FreeIdxList freeIdxList;
+	using Clock = std::chrono::steady_clock;
+
+	static constexpr size_t hugePageLen = 2 * 1024 * 1024;
+
+	struct ClassLayout
+	{
+		u32    firstIdx = 0;  // Pool-wide index of the first slot
+		size_t offset   = 0;  // Byte offset of the first slot
+	};
+
+	struct SizeClass
+	{
+		std::unique_ptr<FreeIdxList> freeList;  // Ready to hand out
+		std::unique_ptr<FreeIdxList> idleList;  // Not part of the pool now, pages given back
+
+		std::atomic<u32> slots      = 0;  // Free or in use, not idle
+		std::atomic<u32> inUse      = 0;
+		std::atomic<u32> highWater  = 0;
+		std::atomic<u32> periodPeak = 0;  // Most in use at once in the current shrink period
+	};
+
+	const Options                           options;
+	std::array<ClassLayout, classCount + 1> layout;
+	const u32                               poolSize;   // Slots of all classes at their cap
+	const size_t                            poolBytes;  // Whole huge pages
+	std::array<SizeClass, classCount>       sizeClasses;
+	std::unique_ptr<std::atomic<i64>[]>     acquiredAt;         // Per slot, Clock ticks
+	u8*                                     poolData = nullptr;  // poolBytes, mmap-ed
+
+	std::atomic<u32> inUse     = 0;
+	std::atomic<u32> highWater = 0;
+	std::atomic<u64> acquired  = 0;
+	std::atomic<u64> failures  = 0;
+	std::atomic<u64> grown     = 0;
+	std::atomic<u64> shrunk    = 0;
+	std::atomic<u64> holdTicks = 0;
+	std::atomic<u64> restores  = 0;
+
+	std::atomic<i64>  periodStart;  // Clock ticks
+	std::atomic<bool> shrinking = false;
+
+	std::atomic<u32>  reclaimThres = UINT32_MAX;  // Off by default
+	std::atomic<bool> lazyReclaim  = true;
+
+	PageMode          pageMode = PageMode::SMALL;
+	std::atomic<bool> locked   = false;
+
+  private:
+	static i64 ticks() noexcept { return Clock::now().time_since_epoch().count(); }
+
+	static void raise(std::atomic<u32>& peak, u32 value) noexcept
+	{
+		auto cur = peak.load(std::memory_order_relaxed);
+		while (cur < value && !peak.compare_exchange_weak(cur, value, std::memory_order_relaxed)) {}
+	}
+
+	static std::array<ClassLayout, classCount + 1> makeLayout(const Options& options)
+	{
+		std::array<ClassLayout, classCount + 1> table{};
+		for (u32 c = 0; c < classCount; c++) {
+			if (options.maxSlots[c] < options.slots[c]) {
+				throw std::invalid_argument("TFramePool: maxSlots is below slots for a size class");
+			}
+
+			table[c + 1].firstIdx = table[c].firstIdx + options.maxSlots[c];
+			table[c + 1].offset   = table[c].offset + size_t{ slotLens[c] } * options.maxSlots[c];
+		}
+		return table;
+	}
+
+	// Map poolBytes of fresh address space, huge page aligned. Returns nullptr and sets errno on
+	// failure.
+	u8* mapPool(bool hugetlb) const noexcept
+	{
+		if (hugetlb) {
+			// No MAP_NORESERVE, a short huge page pool must fail here rather than SIGBUS later
+			constexpr int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+
+			auto mem = ::mmap(nullptr, poolBytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+			return mem == MAP_FAILED ? nullptr : static_cast<u8*>(mem);
+		}
+
+		// Reserve only, the zeroed pages are faulted in on first write. One extra huge page of
+		// address space lets the pool start on a huge page boundary, which THP needs.
+		constexpr int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+
+		auto mem = ::mmap(nullptr, poolBytes + hugePageLen, PROT_READ | PROT_WRITE, flags, -1, 0);
+		if (mem == MAP_FAILED) { return nullptr; }
+
+		auto base = reinterpret_cast<uintptr_t>(mem);
+		auto head = (hugePageLen - base % hugePageLen) % hugePageLen;
+
+		if (head > 0) { ::munmap(mem, head); }
+		::munmap(reinterpret_cast<void*>(base + head + poolBytes), hugePageLen - head);
+
+		return reinterpret_cast<u8*>(base + head);
+	}
+
+	u8* slotData(u32 idx) noexcept
+	{
+		u32 c = classOf(idx);
+		return poolData + layout[c].offset + size_t{ idx - layout[c].firstIdx } * slotLens[c];
+	}
+
+	// Pop a free slot of class `c`, bringing in an idle one if none is free
+	bool take(u32 c, u32& idx) noexcept
+	{
+		auto& sizeClass = sizeClasses[c];
+
+		if (!sizeClass.freeList->pop(idx)) {
+			if (!sizeClass.idleList->pop(idx)) { return false; }
+
+			sizeClass.slots.fetch_add(1, std::memory_order_relaxed);
+			grown.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		auto classInUse = sizeClass.inUse.fetch_add(1, std::memory_order_relaxed) + 1;
+		raise(sizeClass.highWater, classInUse);
+		raise(sizeClass.periodPeak, classInUse);
+		raise(highWater, inUse.fetch_add(1, std::memory_order_relaxed) + 1);
+
+		return true;
+	}
+
+	// Once per shrink period, retire the grown slots the period did not need
+	void maybeShrink(i64 now) noexcept
+	{
+		auto period = std::chrono::duration_cast<Clock::duration>(options.shrinkAfter).count();
+		if (period <= 0 || now - periodStart.load(std::memory_order_relaxed) < period) { return; }
+		if (shrinking.exchange(true, std::memory_order_acquire)) { return; }
+
+		for (u32 c = 0; c < classCount; c++) {
+			auto& sizeClass = sizeClasses[c];
+
+			u32 peak = sizeClass.periodPeak.exchange(
+				sizeClass.inUse.load(std::memory_order_relaxed), std::memory_order_relaxed
+			);
+			u32 keep = std::max(options.slots[c], peak);
+
+			u32 idx;
+			while (sizeClass.slots.load(std::memory_order_relaxed) > keep &&
+				   sizeClass.freeList->pop(idx)) {
+				reclaim(idx, false);
+				sizeClass.idleList->push(idx);
+				sizeClass.slots.fetch_sub(1, std::memory_order_relaxed);
+				shrunk.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		periodStart.store(now, std::memory_order_relaxed);
+		shrinking.store(false, std::memory_order_release);
+	}
 
   public:
-	std::optional<FrameData> acquire()
+	/**
+	 * @brief 取一个至少能容纳 `len` 字节的槽位。所属的一级耗尽时先在上限内增长，
+	 *        仍然不够再向更大的一级借用。
+	 * @return 若没有足够大的空闲槽位，返回 std::nullopt。
+	 * @note MT-SAFE
+	 */
+	std::optional<FrameData> acquire(u32 len = slotLen)
+	{
+		auto now = ticks();
+		maybeShrink(now);
+
+		for (u32 c = classFor(len); c < classCount; c++) {
+			u32 idx;
+			if (take(c, idx)) {
+				acquiredAt[idx].store(now, std::memory_order_relaxed);
+				acquired.fetch_add(1, std::memory_order_relaxed);
+				return FrameData(this, slotData(idx), idx);
+			}
+		}
+
+		failures.fetch_add(1, std::memory_order_relaxed);
+		return std::nullopt;
+	}
+
+	/**
+	 * @note MT-SAFE。各个计数器分别读取，彼此之间不保证是同一时刻的值。
+	 */
+	Stats getStats() const noexcept
+	{
+		Stats stats;
+
+		for (u32 c = 0; c < classCount; c++) {
+			const auto& sizeClass = sizeClasses[c];
+
+			stats.classes[c] = { .slotLen   = slotLens[c],
+								 .slots     = sizeClass.slots.load(std::memory_order_relaxed),
+								 .maxSlots  = options.maxSlots[c],
+								 .inUse     = sizeClass.inUse.load(std::memory_order_relaxed),
+								 .highWater = sizeClass.highWater.load(std::memory_order_relaxed) };
+		}
+
+		stats.inUse     = inUse.load(std::memory_order_relaxed);
+		stats.highWater = highWater.load(std::memory_order_relaxed);
+		stats.acquired  = acquired.load(std::memory_order_relaxed);
+		stats.failures  = failures.load(std::memory_order_relaxed);
+		stats.grown     = grown.load(std::memory_order_relaxed);
+		stats.shrunk    = shrunk.load(std::memory_order_relaxed);
+
+		if (auto count = restores.load(std::memory_order_relaxed); count > 0) {
+			auto avg = Clock::duration(holdTicks.load(std::memory_order_relaxed) / count);
+			stats.avgHoldTime = std::chrono::duration_cast<std::chrono::microseconds>(avg);
+		}
+
+		return stats;
+	}
+
+	const Options& getOptions() const noexcept { return options; }
+
+	/**
+	 * @brief 归还长度不小于 `bytes` 的槽位时，把它的物理页交还给内核，使常驻内存在关键帧等
+	 *        大帧过后回落。
+	 * @param bytes 传入 UINT32_MAX 关闭（默认）。
+	 * @param lazy  为 true 时使用 MADV_FREE（内核不支持时退回 MADV_DONTNEED），页面只在内存
+	 *              紧张时才被回收，开销最小；为 false 时使用 MADV_DONTNEED，立即释放。
+	 * @note MT-SAFE。被交还的槽位再次写入时会重新产生缺页，只适合不常用的大槽位。
+	 */
+	void setReclaimThreshold(u32 bytes, bool lazy = true) noexcept
+	{
+		lazyReclaim.store(lazy);
+		reclaimThres.store(bytes);
+	}
+	u32 getReclaimThreshold() const noexcept { return reclaimThres.load(); }
+
+	/**
+	 * @brief 切换槽位所在内存的页大小，减少拷贝与解码大帧时的 TLB 缺失。
+	 *
+	 * TRANSPARENT_HUGE 只是建议，内核是否真的使用大页取决于
+	 * /sys/kernel/mm/transparent_hugepage 的配置，可在 /proc/self/smaps 的 AnonHugePages 中确认。
+	 * 进出 EXPLICIT_HUGE 需要重新映射整个池，原有的槽位内容不会保留。
+	 *
+	 * @return 成功返回 0，否则返回 errno：进出 EXPLICIT_HUGE 时仍有槽位未归还返回 EBUSY，系统
+	 *         大页不足返回 ENOMEM，内核不支持 THP 返回 EINVAL。失败时保持原有的页模式，除非
+	 *         从 EXPLICIT_HUGE 重新映射后 MADV_HUGEPAGE 失败，此时退回 SMALL。
+	 * @note NOT MT-SAFE，应在开始推流之前调用。锁定状态会被保留。显式大页按增长上限一次性
+	 *       占用全部大页。
+	 */
+	int setPageMode(PageMode mode) noexcept
+	{
+		if (mode == pageMode) { return 0; }
+
+		if (mode == PageMode::EXPLICIT_HUGE || pageMode == PageMode::EXPLICIT_HUGE) {
+			if (inUse.load() != 0) { return EBUSY; }
+
+			auto mem = mapPool(mode == PageMode::EXPLICIT_HUGE);
+			if (!mem) { return errno; }
+
+			if (locked.load() && ::mlock(mem, poolBytes) != 0) {
+				auto err = errno;
+				::munmap(mem, poolBytes);
+				return err;
+			}
+
+			::munmap(poolData, poolBytes);
+			poolData = mem;
+			pageMode = mode == PageMode::EXPLICIT_HUGE ? mode : PageMode::SMALL;
+		}
+
+		if (mode == PageMode::TRANSPARENT_HUGE) {
+			if (::madvise(poolData, poolBytes, MADV_HUGEPAGE) != 0) { return errno; }
+		} else if (pageMode == PageMode::TRANSPARENT_HUGE) {
+			if (::madvise(poolData, poolBytes, MADV_NOHUGEPAGE) != 0) { return errno; }
+		}
+
+		pageMode = mode;
+		return 0;
+	}
+	PageMode getPageMode() const noexcept { return pageMode; }
+
+	/**
+	 * @brief 用 mlock 把整个池锁定在内存中：所有页立即分配，之后不会再因首次写入或换出而缺页。
+	 * @return 成功返回 0，否则返回 errno，通常是超过 RLIMIT_MEMLOCK 时的 ENOMEM 或 EPERM。
+	 * @note NOT MT-SAFE，应在开始推流之前调用。锁定的是增长上限对应的全部内存，锁定后
+	 *       setReclaimThreshold() 与收缩都不再交还物理页。
+	 */
+	int setLocked(bool lock) noexcept
 	{
-		u32 idx;
-		if (!freeIdxList.try_dequeue(idx)) { return std::nullopt; }
-		return FrameData(this, &poolData[idx], idx);
+		if (lock == locked.load()) { return 0; }
+
+		if ((lock ? ::mlock(poolData, poolBytes) : ::munlock(poolData, poolBytes)) != 0) {
+			return errno;
+		}
+
+		locked.store(lock);
+		return 0;
 	}
+	bool isLocked() const noexcept { return locked.load(); }
 
   private:
+	// Give the pages of a slot back to the kernel, its content is garbage from now on
+	void reclaim(u32 idx, bool lazy) noexcept
+	{
+		if (locked.load(std::memory_order_relaxed)) { return; }  // Pinned on purpose
+
+		auto addr = slotData(idx);
+		auto len  = slotCapacity(idx);
+
+#ifdef MADV_FREE
+		if (lazy && ::madvise(addr, len, MADV_FREE) == 0) { return; }  // EINVAL before Linux 4.5
+#endif
+		::madvise(addr, len, MADV_DONTNEED);
+	}
+
 	bool restore(u32 idx)
 	{
 		if (idx >= poolSize) { return false; }
 
-		return freeIdxList.try_enqueue(idx);
+		auto held = ticks() - acquiredAt[idx].load(std::memory_order_relaxed);
+		holdTicks.fetch_add(static_cast<u64>(std::max<i64>(held, 0)), std::memory_order_relaxed);
+		restores.fetch_add(1, std::memory_order_relaxed);
+
+		if (slotCapacity(idx) >= reclaimThres.load(std::memory_order_relaxed)) {
+			reclaim(idx, lazyReclaim.load(std::memory_order_relaxed));
+		}
+
+		auto& sizeClass = sizeClasses[classOf(idx)];
+		sizeClass.inUse.fetch_sub(1, std::memory_order_relaxed);
+		inUse.fetch_sub(1, std::memory_order_relaxed);
+
+		sizeClass.freeList->push(idx);
+		return true;
 	}
 
   public:
-	TFramePool() : poolData(), freeIdxList(poolSize)
+	/**
+	 * @throw std::invalid_argument if a class has `maxSlots` below `slots`.
+	 * @throw std::runtime_error if the address space of the pool cannot be mapped.
+	 */
+	explicit TFramePool(const Options& _options = {}) :
+		options(_options),
+		layout(makeLayout(_options)),
+		poolSize(layout.back().firstIdx),
+		poolBytes((layout.back().offset + hugePageLen - 1) / hugePageLen * hugePageLen),
+		acquiredAt(std::make_unique<std::atomic<i64>[]>(poolSize)),
+		periodStart(ticks())
 	{
-		std::memset(poolData.data(), 0, sizeof(poolData));
+		poolData = mapPool(false);
+		if (!poolData) {
+			throw std::runtime_error(
+				std::string("Failed to map the frame pool: ") + std::strerror(errno)
+			);
+		}
+
+		for (u32 c = 0; c < classCount; c++) {
+			auto& sizeClass = sizeClasses[c];
+			u32   first     = layout[c].firstIdx;
+
+			sizeClass.freeList = std::make_unique<FreeIdxList>(first, options.maxSlots[c]);
+			sizeClass.idleList = std::make_unique<FreeIdxList>(first, options.maxSlots[c]);
+			sizeClass.slots.store(options.slots[c]);
 
-		for (u32 i = 0; i < poolSize; i++) { freeIdxList.try_enqueue(i); }
+			// Lowest index on top, the slots beyond the initial size wait in the idle list
+			for (u32 i = layout[c + 1].firstIdx; i > first; i--) {
+				auto& list = i - 1 - first < options.slots[c] ? sizeClass.freeList
+															  : sizeClass.idleList;
+				list->push(i - 1);
+			}
+		}
 	}
 
-	~TFramePool() = default;
+	~TFramePool() { ::munmap(poolData, poolBytes); }
 
-	[[nodiscard("Should not ignore the created TFramePool::SharedPtr")]] static SharedPtr create()
+	[[nodiscard("Should not ignore the created TFramePool::SharedPtr")]] static SharedPtr create(
+		const Options& _options = {}
+	)
 	{
-		return std::make_shared<TFramePool>();
+		return std::make_shared<TFramePool>(_options);
 	}
 
 	TFramePool(const TFramePool&)            = delete;  // Forbid copy or move
@@ -134,4 +640,4 @@ class [[gnu::aligned(64)]] TFramePool
 	TFramePool(TFramePool&&)                 = delete;
 	TFramePool& operator=(TFramePool&&)      = delete;
 };
-}  // namespace gentau
\ No newline at end of file
+}  // namespace gentau
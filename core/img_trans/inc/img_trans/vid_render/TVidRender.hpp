@@ -3,6 +3,7 @@
 #include "img_trans/vid_render/TFramePool.hpp"
 
 #include "utils/TSignal.hpp"
+#include "utils/TThreadPolicy.hpp"
 #include "utils/TTypeRedef.hpp"
 
 #include <atomic>
@@ -25,11 +26,14 @@ extern "C"
 }
 
 namespace gentau {
-class TReassembly;
+template<typename Policy>
+class TBasicReassembly;
 
 class TReassemblyPasskey
 {
-	friend class TReassembly;
+	template<typename Policy>
+	friend class TBasicReassembly;
+
 	TReassemblyPasskey() = default;
 };
 
@@ -40,8 +44,21 @@ class TVidRender : public std::enable_shared_from_this<TVidRender>
 	using ElemRawPtr = GstElement*;
 
   public:
-	using TimePoint = std::chrono::steady_clock::time_point;
-	using SharedPtr = std::shared_ptr<TVidRender>;
+	using TimePoint     = std::chrono::steady_clock::time_point;
+	using WallTimePoint = std::chrono::system_clock::time_point;
+	using SharedPtr     = std::shared_ptr<TVidRender>;
+
+	/**
+	 * @brief Kernel arrival time (CLOCK_REALTIME) of the earliest and the latest received
+	 *        section of a frame. A default constructed time point means "unknown".
+	 */
+	struct RxTimestamps
+	{
+		WallTimePoint first{};
+		WallTimePoint last{};
+
+		bool isValid() const noexcept { return first != WallTimePoint{} && last >= first; }
+	};
 
   public:
 	enum class IssueType : u32
@@ -140,9 +157,11 @@ class TVidRender : public std::enable_shared_from_this<TVidRender>
   private:
 	std::atomic<TimePoint> lastPushSuccess = TimePoint::min();
 	std::atomic<u64>       maxBufferBytes  = 262'144;  // Default to 256 KB
+	std::atomic<u64>       decoderResets   = 0;  // Successful flush() / restart() calls
 
-	const bool useFileSrc;
-	const bool enableTestMode;
+	const bool          useFileSrc;
+	const bool          enableTestMode;
+	const TThreadPolicy busThreadPolicy;  // Applied by the bus thread itself on start
 
   private:
 	std::jthread busThread;
@@ -154,9 +173,36 @@ class TVidRender : public std::enable_shared_from_this<TVidRender>
 	// MT-SAFE, but should be used with caution as it may cause pushFrame to fail if set too low.
 	void setMaxBufferBytes(u64 bytes) { maxBufferBytes.store(bytes); }
 
+	// MT-SAFE. Frame slots of at least `bytes` give their pages back to the kernel when the
+	// decoder releases them, see TFramePool::setReclaimThreshold(). UINT32_MAX turns it off.
+	void setFrameReclaimThreshold(u32 bytes, bool lazy = true)
+	{
+		framePool.setReclaimThreshold(bytes, lazy);
+	}
+
+	// MT-SAFE. Occupancy, high-water marks, acquire failures and hold time of the frame pool,
+	// to size TFramePoolOptions from a real deployment
+	TFramePool::Stats getFramePoolStats() const { return framePool.getStats(); }
+
+	/**
+	 * @brief 设置帧缓冲池的页大小与是否锁定在内存中，参见 TFramePool::setPageMode() 与
+	 *        TFramePool::setLocked()。
+	 *
+	 * 显式大页被拒绝时退回透明大页，透明大页也被拒绝时保持原有的页大小；锁定失败时保持不锁定。
+	 * 每一次退回都会打印警告，最终生效的配置以 Info 级别打印。
+	 *
+	 * @return 完全按要求生效时返回 true，发生任何退回时返回 false。
+	 * @note NOT MT-SAFE，应在开始推流之前调用。
+	 */
+	bool setFramePoolBacking(TFramePool::PageMode pages, bool lock);
+
 	// MT-SAFE
 	TimePoint getLastPushSuccessTime() const { return lastPushSuccess.load(); }
 
+	// MT-SAFE. Bumped by every flush() / restart(), after which the decoder has lost the
+	// parameter sets and reference frames it had seen.
+	u64 getDecoderResetCount() const { return decoderResets.load(); }
+
   private:
 	static void onDecoderPadAdded(GstElement* decoder, GstPad* new_pad, gpointer user_data);
 
@@ -184,21 +230,29 @@ class TVidRender : public std::enable_shared_from_this<TVidRender>
 
 	/**
 	 * @brief 尝试推送一帧数据到渲染管道中。
+	 * @param rxTs 该帧首个与最后一个分片的内核接收时间戳。若有效，将以 GstReferenceTimestampMeta
+	 *        （caps 为 `timestamp/x-unix`，timestamp 为首个分片到达时间，duration 为首末分片的
+	 *        到达间隔）附加到 GstBuffer 上；同时附加一个 caps 为 `timestamp/x-gentau-push` 的
+	 *        GstReferenceTimestampMeta 记录推送时的系统时间，下游可据此区分内核队列、重组与解码
+	 *        各自消耗的时间。
 	 * @return 在帧数据成功推送到管道返回 true，否则返回 false。
 	 * @note 该方法仅能在 TReassembly 类内部被正常调用，其他地方调用此方法将导致编译
 	 *       错误。该方法当且仅当存在单一调用者时才是线程安全的，请勿在多个线程中并发调
 	 *       用此方法。
 	 */
-	bool tryPushFrame(TFramePool::FrameData&& frame, TReassemblyPasskey);
+	bool tryPushFrame(TFramePool::FrameData&& frame, RxTimestamps rxTs, TReassemblyPasskey);
 
 	/**
-	 * @brief 尝试获取一个可用的帧数据槽位。
+	 * @brief 尝试获取一个至少能容纳 `frameLen` 字节的帧数据槽位。
 	 * @return std::optional<TFramePool::FrameData>
 	 * @note 该方法仅能在 TReassembly 类内部被正常调用，其他地方调用此方法将导致编译
 	 *       错误。该方法当且仅当存在单一调用者时才是线程安全的，请勿在多个线程中并发调
 	 *       用此方法。
 	 */
-	auto acquireFrameSlot(TReassemblyPasskey) { return framePool.acquire(); }
+	auto acquireFrameSlot(u32 frameLen, TReassemblyPasskey)
+	{
+		return framePool.acquire(frameLen);
+	}
 
   public:
 	/** 
@@ -266,26 +320,45 @@ class TVidRender : public std::enable_shared_from_this<TVidRender>
 
   public:
 	explicit TVidRender(
-		u64 _maxBufferBytes = 262'144, bool _enableTestMode = false
+		u64                 _maxBufferBytes  = 262'144,
+		bool                _enableTestMode  = false,
+		TThreadPolicy       _busThreadPolicy = {},
+		TFramePool::Options _poolOptions     = {}
 	);  // Default to 256 KB
 	explicit TVidRender(
-		const char* file_path, u64 _maxBufferBytes = 262'144, bool _enableTestMode = false
+		const char*         file_path,
+		u64                 _maxBufferBytes  = 262'144,
+		bool                _enableTestMode  = false,
+		TThreadPolicy       _busThreadPolicy = {},
+		TFramePool::Options _poolOptions     = {}
 	);
 
 	/** 
 	 * @brief create a shared pointer to TVidRender instance. 
 	 *
+	 * @param busThreadPolicy Scheduling policy applied by the GStreamer bus thread, see
+	 *        TThreadPolicy.
+	 * @param poolOptions Size of the frame pool per size class and how far it may grow, see
+	 *        TFramePoolOptions.
 	 * @throws std::runtime_error if the pipeline initialization failed, or 
 	 *         if file_path is provided in non-Debug builds.
+	 * @throws std::invalid_argument if poolOptions caps a size class below its initial size.
 	 */
 	[[nodiscard("Should not ignored the created TVidRender::SharedPtr")]] static SharedPtr create(
-		const char* file_path = nullptr, u64 _maxBufferBytes = 262'144
+		const char*         file_path       = nullptr,
+		u64                 _maxBufferBytes = 262'144,
+		TThreadPolicy       busThreadPolicy = {},
+		TFramePool::Options poolOptions     = {}
 	)
 	{
 		if (file_path) {
-			return std::make_shared<TVidRender>(file_path, _maxBufferBytes);
+			return std::make_shared<TVidRender>(
+				file_path, _maxBufferBytes, false, std::move(busThreadPolicy), poolOptions
+			);
 		} else {
-			return std::make_shared<TVidRender>(_maxBufferBytes);
+			return std::make_shared<TVidRender>(
+				_maxBufferBytes, false, std::move(busThreadPolicy), poolOptions
+			);
 		}
 	}
 
@@ -293,12 +366,17 @@ class TVidRender : public std::enable_shared_from_this<TVidRender>
 	 * @brief create a shared pointer to TVidRender instance.
 	 *
 	 * @throws std::runtime_error if the pipeline initialization failed.
+	 * @throws std::invalid_argument if poolOptions caps a size class below its initial size.
 	 */
 	[[nodiscard("Should not ignored the created TVidRender::SharedPtr")]] static SharedPtr create(
-		u64 _maxBufferBytes
+		u64                 _maxBufferBytes,
+		TThreadPolicy       busThreadPolicy = {},
+		TFramePool::Options poolOptions     = {}
 	)
 	{
-		return std::make_shared<TVidRender>(_maxBufferBytes);
+		return std::make_shared<TVidRender>(
+			_maxBufferBytes, false, std::move(busThreadPolicy), poolOptions
+		);
 	}
 
 	/**
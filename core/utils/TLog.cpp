@@ -2,8 +2,12 @@
 
 #include <chrono>
 #include <ctime>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "spdlog/async.h"
@@ -18,12 +22,34 @@ namespace spd = spdlog;
 using namespace std;
 
 namespace gentau {
+static TThreadPolicy logThreadPolicy;
+
+// Written once by the worker thread before createSinks() returns, read-only afterwards
+static optional<TThreadPolicy::Applied> logThreadApplied;
+
+void setLogThreadPolicy(TThreadPolicy policy)
+{
+	logThreadPolicy = std::move(policy);
+}
+
 static vector<spd::sink_ptr> createSinks()
 {
 	static vector<spd::sink_ptr> sinks = []() {
 		vector<spd::sink_ptr> s_list;
 
-		spd::init_thread_pool(8192, 1);
+		if (logThreadPolicy.isDefault()) {
+			spd::init_thread_pool(8192, 1);
+		} else {
+			// The worker must not log here: the loggers are still being created on this thread
+			promise<TThreadPolicy::Applied> applied;
+			auto                            appliedFuture = applied.get_future();
+
+			spd::init_thread_pool(8192, 1, [&applied]() {
+				applied.set_value(logThreadPolicy.apply("gt-spdlog"));
+			});
+
+			logThreadApplied = appliedFuture.get();
+		}
 
 		if constexpr (conf::TLogToConsole) {
 			auto stdout_sink = make_shared<spd::sinks::stdout_color_sink_mt>();
@@ -72,6 +98,14 @@ static LoggerPtr createAsyncLogger(const string& logger_name)
 	logger->flush_on(spd::level::err);
 
 	spd::register_logger(logger);
+
+	static once_flag reportOnce;
+	call_once(reportOnce, [&logger]() {
+		if (logThreadApplied) {
+			logger->info("[Logger] Worker thread policy applied: {}", logThreadApplied->toString());
+		}
+	});
+
 	return logger;
 }
 
@@ -1,6 +1,11 @@
 #include "utils/TScheduler.hpp"
 
+#include "utils/TLog.hpp"
+
 #include <stop_token>
+#include <utility>
+
+#define T_LOG_TAG "[Scheduler] "
 
 using namespace std;
 using namespace std::chrono;
@@ -33,11 +38,16 @@ bool TScheduler::removeTask(TaskHandle hndl)
 	return true;
 }
 
-void TScheduler::run()
+void TScheduler::run(TThreadPolicy policy)
 {
 	if (eventLoop.joinable()) { return; }
 
-	eventLoop = jthread([this](stop_token sToken) {
+	eventLoop = jthread([this, policy = std::move(policy)](stop_token sToken) {
+		if (!policy.isDefault()) {
+			[[maybe_unused]] auto applied = policy.apply("gt-scheduler");
+			tLogInfo("Event loop thread policy applied: {}", applied.toString());
+		}
+
 		while (!sToken.stop_requested()) {
 			TaskIdentifier nextTid;
 			{
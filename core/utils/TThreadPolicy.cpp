@@ -0,0 +1,204 @@
+#include "utils/TThreadPolicy.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include <cerrno>
+#include <cstdint>
+
+#include <algorithm>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace gentau {
+namespace {
+using Sched = TThreadPolicy::Sched;
+
+string_view schedName(Sched sched) noexcept
+{
+	switch (sched) {
+		case Sched::INHERIT:
+			return "INHERIT";
+		case Sched::NICE:
+			return "NICE";
+		case Sched::FIFO:
+			return "FIFO";
+		case Sched::RR:
+			return "RR";
+		default:
+			return "UNDEFINED";
+	}
+}
+
+/**
+ * @return The priority actually set, or 0 if the real-time class was refused.
+ */
+i32 setRealtime(Sched sched, i32 priority) noexcept
+{
+	int policy = sched == Sched::FIFO ? SCHED_FIFO : SCHED_RR;
+
+	sched_param param{};
+	param.sched_priority =
+		clamp(priority, sched_get_priority_min(policy), sched_get_priority_max(policy));
+
+	// pthread functions return the error code instead of setting errno
+	auto err = ::pthread_setschedparam(::pthread_self(), policy, &param);
+	if (err == 0) { return param.sched_priority; }
+
+	// Unprivileged processes may still use real-time priorities up to RLIMIT_RTPRIO
+	rlimit lim{};
+	if (err == EPERM && ::getrlimit(RLIMIT_RTPRIO, &lim) == 0 && lim.rlim_cur > 0) {
+		// RLIM_INFINITY does not fit an i32, clamp before narrowing
+		auto rtprio          = static_cast<i32>(min<rlim_t>(lim.rlim_cur, 99));
+		param.sched_priority = min<i32>(param.sched_priority, rtprio);
+		if (::pthread_setschedparam(::pthread_self(), policy, &param) == 0) {
+			return param.sched_priority;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @return The nice value actually set, or INT32_MIN if it was refused.
+ */
+i32 setNice([[maybe_unused]] i32 nice) noexcept
+{
+#ifdef __linux__
+	// Linux keeps the nice value per task, so PRIO_PROCESS with a tid targets a single thread
+	auto tid = static_cast<id_t>(::syscall(SYS_gettid));
+	nice     = clamp(nice, -20, 19);
+
+	if (::setpriority(PRIO_PROCESS, tid, nice) == 0) { return nice; }
+
+	// Without CAP_SYS_NICE the nice value can only be lowered down to 20 - RLIMIT_NICE
+	rlimit lim{};
+	if (nice < 0 && ::getrlimit(RLIMIT_NICE, &lim) == 0) {
+		auto allowed = max(nice, 20 - static_cast<i32>(min<rlim_t>(lim.rlim_cur, 40)));
+		if (allowed < 0 && ::setpriority(PRIO_PROCESS, tid, allowed) == 0) { return allowed; }
+	}
+#endif
+	return INT32_MIN;
+}
+
+bool setAffinity([[maybe_unused]] const vector<u32>& cpus, [[maybe_unused]] bool& degraded)
+{
+#ifdef __linux__
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (auto cpu : cpus) {
+		if (cpu < CPU_SETSIZE) { CPU_SET(cpu, &set); }
+	}
+
+	if (::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) == 0) { return true; }
+
+	// Some of the CPUs may be offline or outside the cpuset of this process, keep the rest
+	cpu_set_t allowed;
+	if (::sched_getaffinity(0, sizeof(allowed), &allowed) != 0) { return false; }
+
+	CPU_AND(&set, &set, &allowed);
+	if (CPU_COUNT(&set) == 0) { return false; }
+
+	degraded = true;
+	return ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) == 0;
+#else
+	return false;
+#endif
+}
+
+bool lockProcessMemory() noexcept
+{
+	static once_flag onceFlag;
+	static bool      locked = false;
+
+	// RLIMIT_MEMLOCK is checked against the whole address space, MCL_ONFAULT does not help
+	call_once(onceFlag, []() { locked = ::mlockall(MCL_CURRENT | MCL_FUTURE) == 0; });
+
+	return locked;
+}
+
+void setThreadName(string_view name) noexcept
+{
+	if (name.empty()) { return; }
+
+	char buf[16] = {};  // Linux limit, including the terminating null
+	name.copy(buf, sizeof(buf) - 1);
+
+#if defined(__APPLE__)
+	::pthread_setname_np(buf);
+#elif defined(__linux__)
+	::pthread_setname_np(::pthread_self(), buf);
+#endif
+}
+}  // namespace
+
+auto TThreadPolicy::apply(string_view threadName) const noexcept -> Applied
+{
+	Applied applied;
+
+	setThreadName(threadName);
+
+	if (!cpus.empty()) {
+		applied.affinity = setAffinity(cpus, applied.degraded);
+		if (!applied.affinity) { applied.degraded = true; }
+	}
+
+	optional<i32> niceWanted;  // Nice 0 is a valid request, e.g. to undo an inherited value
+
+	if (sched == Sched::FIFO || sched == Sched::RR) {
+		if (auto prio = setRealtime(sched, priority); prio > 0) {
+			applied.sched    = sched;
+			applied.priority = prio;
+			if (prio != priority) { applied.degraded = true; }
+		} else {
+			applied.degraded = true;
+			niceWanted       = fallbackNice;
+		}
+	} else if (sched == Sched::NICE) {
+		niceWanted = priority;
+	}
+
+	if (niceWanted.has_value()) {
+		if (auto nice = setNice(niceWanted.value()); nice != INT32_MIN) {
+			applied.sched    = Sched::NICE;
+			applied.priority = nice;
+			if (nice != niceWanted.value()) { applied.degraded = true; }
+		} else {
+			applied.degraded = true;
+		}
+	}
+
+	if (lockMemory) {
+		applied.memoryLocked = lockProcessMemory();
+		if (!applied.memoryLocked) { applied.degraded = true; }
+	}
+
+	return applied;
+}
+
+string TThreadPolicy::Applied::toString() const
+{
+	string str = "sched ";
+	str += schedName(sched);
+	if (sched != Sched::INHERIT) { str += " " + to_string(priority); }
+
+	str += affinity ? ", affinity set" : ", affinity inherited";
+	str += memoryLocked ? ", memory locked" : ", memory not locked";
+
+	if (degraded) { str += " (degraded, missing privileges or invalid settings)"; }
+
+	return str;
+}
+}  // namespace gentau
@@ -2,6 +2,8 @@
 
 #include "conf/version.hpp"
 
+#include "utils/TThreadPolicy.hpp"
+
 #include <memory>
 
 #include "spdlog/async_logger.h"
@@ -20,6 +22,14 @@ LoggerPtr getCommLogger();
 // DO NOT CALL THIS DIRECTLY
 LoggerPtr getGeneralLogger();
 
+/**
+ * @brief Set the scheduling policy of the spdlog worker thread. Only takes effect if called
+ *        before the first log is written (i.e. before any logger is created), the policy
+ *        actually applied is logged once by the first logger.
+ * @note NOT MT-SAFE! Call it at the very beginning of main().
+ */
+void setLogThreadPolicy(TThreadPolicy policy);
+
 }  // namespace gentau
 
 #if defined(GEN_TAU_LOG_ENABLED) && (GEN_TAU_LOG_ENABLED == 1)
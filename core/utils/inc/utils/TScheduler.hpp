@@ -1,5 +1,6 @@
 #pragma once
 
+#include "utils/TThreadPolicy.hpp"
 #include "utils/TTypeRedef.hpp"
 
 #include <atomic>
@@ -150,10 +151,11 @@ class TScheduler
 
 	/**
 	 * @brief 启动调度器
+	 * @param policy 事件循环线程在启动时对自身应用的调度策略，参见 TThreadPolicy。
 	 * @note 非多线程安全！强烈建议仅在创建了当前 TScheduler 实例的线程中调用此方法。该方法
 	 *       可以多次调用，如果检查到调度器已经启动，该方法会立即返回。
 	 */
-	void run();
+	void run(TThreadPolicy policy = {});
 
 	/**
 	 * @brief 停止调度器，该方法会阻塞直到调度器完全停止
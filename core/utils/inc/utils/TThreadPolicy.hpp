@@ -0,0 +1,73 @@
+#pragma once
+
+#include "utils/TTypeRedef.hpp"
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace gentau {
+/**
+ * TThreadPolicy 描述了一个线程的调度策略：CPU 亲和性、调度类（SCHED_FIFO / SCHED_RR 或 nice 值）
+ * 以及是否锁定进程内存（mlockall）。
+ *
+ * 需要低延迟的线程（TRecv 的接收线程、TVidRender 的总线线程、TScheduler 的事件循环以及 spdlog
+ * 的日志线程）均可以在启动时由线程自身调用 `apply()` 应用该策略。当前进程缺少相应的权限
+ * （CAP_SYS_NICE、RLIMIT_RTPRIO、RLIMIT_MEMLOCK 等）时，`apply()` 会尽可能地降级而不是失败，
+ * 并通过返回的 `Applied` 报告实际生效的设置。
+ *
+ * 默认构造的 TThreadPolicy 不会改变线程的任何属性。
+ *
+ * @note 调度类与 CPU 亲和性仅在 Linux 上完全支持，其他平台上仅尝试设置实时调度类。
+ */
+struct TThreadPolicy
+{
+	enum class Sched : u8
+	{
+		INHERIT = 0,  // Keep whatever the creating thread had
+		NICE,         // SCHED_OTHER with `priority` as the nice value (-20 ~ 19)
+		FIFO,         // SCHED_FIFO with `priority` as the real-time priority (1 ~ 99)
+		RR,           // SCHED_RR with `priority` as the real-time priority (1 ~ 99)
+	};
+
+	/**
+	 * @brief What `apply()` actually managed to set up.
+	 */
+	struct Applied
+	{
+		Sched sched    = Sched::INHERIT;
+		i32   priority = 0;  // Real-time priority or nice value, depending on `sched`
+
+		bool affinity     = false;  // The CPU mask has been set
+		bool memoryLocked = false;  // The process memory is locked, by this or an earlier call
+		bool degraded     = false;  // Something requested could not be applied as is
+
+		std::string toString() const;
+	};
+
+	Sched sched    = Sched::INHERIT;
+	i32   priority = 0;
+
+	// Nice value used when SCHED_FIFO / SCHED_RR is refused, std::nullopt means no fallback
+	std::optional<i32> fallbackNice;
+
+	std::vector<u32> cpus;  // CPU affinity, empty keeps the inherited mask
+
+	// mlockall(MCL_CURRENT | MCL_FUTURE), process wide and only attempted once per process
+	bool lockMemory = false;
+
+	/**
+	 * @brief Apply the policy to the calling thread and name it `threadName` (truncated to 15
+	 *        characters on Linux, ignored if empty).
+	 * @note MT-SAFE. Does not log, so it is safe to call from the logging thread itself; the
+	 *       caller is expected to report `Applied::toString()`.
+	 */
+	Applied apply(std::string_view threadName = {}) const noexcept;
+
+	bool isDefault() const noexcept
+	{
+		return sched == Sched::INHERIT && cpus.empty() && !lockMemory;
+	}
+};
+}  // namespace gentau
@@ -14,6 +14,7 @@ VERBOSE=0
 
 DO_MEM_PROF=0
 DO_TEST=0
+DO_TOOLS=0
 LOG=1
 LOG_FILE=1
 LOG_CONSOLE=1
@@ -38,6 +39,7 @@ while [[ "$#" -gt 0 ]]; do
 
         -m|--mem-prof)         DO_MEM_PROF=1 ;;
         -T|--build-test)       DO_TEST=1     ;;
+        --build-tools)         DO_TOOLS=1    ;;
         
         -h|--help)      
             echo "Usage: $0 [options]"
@@ -56,6 +58,7 @@ while [[ "$#" -gt 0 ]]; do
             echo ""
             echo "Build Options:"
             echo "  -T, --build-test       Build tests (default: off)"
+            echo "  --build-tools          Build developer tools (default: off)"
             echo "  -m, --mem-prof         Enable memory profiling (default: off)"
             echo "  -n, --no-log           Disable all logging (default: off)"
             echo "  --no-log-file          Disable log file output (default: off)"
@@ -97,6 +100,7 @@ cmake -S "$SRC_DIR" -G "$GENERATOR" -DCMAKE_BUILD_TYPE="$BUILD_TYPE" -B "$BUILD_
     -DGEN_TAU_LOG_LEVEL="$LOG_LEVEL" \
     -DGEN_TAU_USE_ASAN="$DO_MEM_PROF" \
     -DGEN_TAU_BUILD_TESTS="$DO_TEST" \
+    -DGEN_TAU_BUILD_TOOLS="$DO_TOOLS" \
 
 if [ $? -ne 0 ]; then
     echo "Error: CMake Configuration failed."
@@ -0,0 +1,196 @@
+#include "img_trans/vid_render/TFramePool.hpp"
+#include "utils/TLog.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#define T_LOG_TAG "[FramePool Stress] "
+
+using namespace gentau;
+using namespace std;
+
+// Frames handed from one thread to another before being dropped, like the GStreamer streaming
+// threads restoring the slots that the reassembly thread acquired
+class Handoff
+{
+  private:
+	mutex                        lock;
+	deque<TFramePool::FrameData> frames;
+
+  public:
+	void put(TFramePool::FrameData&& frame)
+	{
+		lock_guard guard(lock);
+		frames.push_back(std::move(frame));
+	}
+
+	bool take(TFramePool::FrameData& frame)
+	{
+		lock_guard guard(lock);
+		if (frames.empty()) { return false; }
+
+		frame = std::move(frames.front());
+		frames.pop_front();
+		return true;
+	}
+
+	void clear()
+	{
+		lock_guard guard(lock);
+		frames.clear();
+	}
+};
+
+TFramePool::SharedPtr framePool;
+Handoff               handoff;
+atomic<u64>           acquired = 0;
+atomic<u64>           misses   = 0;
+atomic<u64>           failures = 0;
+
+vector<atomic<u32>> owners;  // Holder thread id + 1 of each slot, 0 if free
+
+// Forget the owner, then give the slot back to the pool
+void drop(TFramePool::FrameData&& frame)
+{
+	owners[frame.index()].store(0);
+	TFramePool::FrameData released(std::move(frame));
+}
+
+void hammer(u32 id, u64 iterations)
+{
+	constexpr array<u32, 5> lengths{ 1'000, 20'000, 200'000, 1'000'000, TFramePool::slotLen };
+
+	u64                           rng = id * 0x9e37'79b9'7f4a'7c15 + 1;
+	vector<TFramePool::FrameData> held;
+
+	for (u64 i = 0; i < iterations; i++) {
+		rng ^= rng << 13;
+		rng ^= rng >> 7;
+		rng ^= rng << 17;
+
+		auto frameOpt = framePool->acquire(lengths[rng % lengths.size()]);
+		if (!frameOpt.has_value()) {
+			misses.fetch_add(1, memory_order_relaxed);
+			if (!held.empty()) {
+				drop(std::move(held.back()));
+				held.pop_back();
+			}
+			continue;
+		}
+
+		auto& frame = frameOpt.value();
+		acquired.fetch_add(1, memory_order_relaxed);
+
+		if (u32 prev = owners[frame.index()].exchange(id + 1); prev != 0) {
+			tLogError(
+				"Slot {} handed to thread {} while thread {} holds it", frame.index(), id, prev - 1
+			);
+			failures.fetch_add(1);
+		}
+
+		memset(frame.data(), static_cast<int>(id), 64);
+		this_thread::yield();
+
+		for (u32 b = 0; b < 64; b++) {
+			if (frame.data()[b] != static_cast<u8>(id)) {
+				tLogError("Slot {} overwritten while thread {} holds it", frame.index(), id);
+				failures.fetch_add(1);
+				break;
+			}
+		}
+
+		switch (rng >> 60 & 3) {
+			case 0:
+				held.push_back(std::move(frame));  // Keep a few, the pool runs dry now and then
+				if (held.size() > 4) {
+					drop(std::move(held.front()));
+					held.erase(held.begin());
+				}
+				break;
+			case 1:
+				handoff.put(std::move(frame));  // Another thread restores it
+				break;
+			default:
+				drop(std::move(frame));
+				break;
+		}
+
+		TFramePool::FrameData other{ nullptr, nullptr, UINT32_MAX };
+		if (handoff.take(other)) { drop(std::move(other)); }
+	}
+
+	for (auto& frame : held) { drop(std::move(frame)); }
+}
+
+// Usage: frame-pool-stress [threads] [iterations per thread]
+int main(int argc, char* argv[])
+{
+	u32 threads    = max(thread::hardware_concurrency(), 4u);
+	u64 iterations = 200'000;
+
+	if (argc > 1) { threads = static_cast<u32>(atoi(argv[1])); }
+	if (argc > 2) { iterations = strtoull(argv[2], nullptr, 10); }
+
+	// Start small and let the pool grow and shrink all the time under the threads
+	TFramePool::Options options;
+	options.slots       = { 16, 4, 2, 1 };
+	options.shrinkAfter = chrono::milliseconds(1);
+
+	u32 poolSize = accumulate(options.maxSlots.begin(), options.maxSlots.end(), 0u);
+
+	framePool = TFramePool::create(options);
+	owners    = vector<atomic<u32>>(poolSize);
+
+	{
+		vector<jthread> workers;
+		for (u32 t = 0; t < threads; t++) { workers.emplace_back(hammer, t, iterations); }
+	}
+	handoff.clear();
+
+	auto stats = framePool->getStats();
+	if (stats.inUse != 0) {
+		tLogError("{} slots still counted in use", stats.inUse);
+		failures.fetch_add(1);
+	}
+
+	// Every slot must be back, exactly once
+	vector<TFramePool::FrameData> all;
+	vector<bool>                  seen(poolSize, false);
+
+	while (auto frameOpt = framePool->acquire(1)) {
+		auto idx = frameOpt->index();
+		if (seen[idx]) {
+			tLogError("Slot {} is in the free lists twice", idx);
+			failures.fetch_add(1);
+		}
+		seen[idx] = true;
+		all.push_back(std::move(frameOpt).value());
+	}
+
+	if (all.size() != poolSize) {
+		tLogError("{} of {} slots came back", all.size(), poolSize);
+		failures.fetch_add(1);
+	}
+
+	tLogInfo(
+		"{} threads, {} acquisitions, {} misses on a dry pool, {} slots grown, {} shrunk, {} "
+		"failures",
+		threads,
+		acquired.load(),
+		misses.load(),
+		stats.grown,
+		stats.shrunk,
+		failures.load()
+	);
+
+	return failures.load() == 0 ? 0 : -1;
+}
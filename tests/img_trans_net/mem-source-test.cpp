@@ -0,0 +1,64 @@
+#include "img_trans/net/TPacketSource.hpp"
+#include "img_trans/net/TReassembly.hpp"
+#include "utils/TLog.hpp"
+
+#include <array>
+#include <cstring>
+#include <span>
+#include <vector>
+
+#define T_LOG_TAG "[MemSource Test] "
+
+using namespace gentau;
+using namespace std;
+
+// 数据集比一次 read() 的批次还小时，一个批次不能跨越两轮回放：下一轮会就地改写帧序号，
+// 已经放进批次的数据报也会跟着变成下一轮的序号
+int main()
+{
+	constexpr u16 frames = 4;
+	constexpr u64 loops  = 3;
+
+	auto source = TMemPacketSource::create();
+
+	array<u8, sizeof(TPacketHeader) + 16> packet{};
+	for (u16 f = 0; f < frames; f++) {
+		TPacketHeader header{ f, 0, 16 };
+		memcpy(packet.data(), &header, sizeof(header));
+		source->append(packet);
+	}
+	source->setLoops(loops);
+
+	vector<u16>                              seen;
+	array<TPacket, TPacketFeeder::batchSize> batch;
+
+	while (!source->isExhausted()) {
+		auto n = source->read(batch);
+		if (n < 0) {
+			tLogError("read() failed: {}", n);
+			return -1;
+		}
+
+		// The spans are only valid until the next read()
+		for (i32 i = 0; i < n; i++) {
+			seen.push_back(TPacketHeader::parse(batch[i].data)->frameIdx);
+		}
+	}
+
+	i32 failures = 0;
+	if (seen.size() != frames * loops) {
+		tLogError("{} datagrams replayed, expected {}", seen.size(), frames * loops);
+		failures++;
+	}
+
+	for (u16 i = 0; i < seen.size(); i++) {
+		if (seen[i] != i) {
+			tLogError("Datagram {} carries frame index {}, expected {}", i, seen[i], i);
+			failures++;
+		}
+	}
+
+	tLogInfo("{} datagrams replayed over {} passes, {} failures", seen.size(), loops, failures);
+
+	return failures == 0 ? 0 : -1;
+}
@@ -0,0 +1,354 @@
+#include "img_trans/net/TImpairment.hpp"
+#include "img_trans/net/TPacketSource.hpp"
+#include "img_trans/net/TReassembly.hpp"
+#include "img_trans/vid_render/TVidRender.hpp"
+#include "utils/TLog.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#define T_LOG_TAG "[Reassembly Bench] "
+
+using namespace gentau;
+using namespace std;
+
+TImpairmentOptions impairOpts;
+string_view        policyName = "default";
+string_view        incomplete = "drop";  // drop | whole | truncate
+u32                holdFrames = 0;       // Jitter buffer depth, 0: off
+u32                holdMs     = 20;
+string_view        pages      = "small";  // small | thp | huge, ":lock" to mlock the frame pool
+u32                poolCap    = 1;        // Frame pool growth cap, times the default size
+
+// 取出 argv 中的损伤与重组策略参数，剩下的参数按原顺序前移
+bool parseOptions(int& argc, char* argv[])
+{
+	int kept = 1;
+
+	for (int i = 1; i < argc; i++) {
+		string_view arg  = argv[i];
+		const char* next = i + 1 < argc ? argv[i + 1] : nullptr;
+
+		auto takeUs = [&]() { return TImpairmentOptions::Duration(strtoll(next, nullptr, 10)); };
+
+		if (arg.size() < 3 || !arg.starts_with("--") || arg == "--capture" || arg == "--replay" ||
+			arg == "--udp") {
+			argv[kept++] = argv[i];
+			continue;
+		}
+
+		if (!next) {
+			tLogError("Missing value for {}", arg);
+			return false;
+		}
+
+		if (arg == "--policy") {
+			policyName = next;
+		} else if (arg == "--incomplete") {
+			incomplete = next;
+		} else if (arg == "--hold") {
+			holdFrames = static_cast<u32>(atoi(next));  // "frames[:ms]"
+			if (auto colon = strchr(next, ':')) { holdMs = static_cast<u32>(atoi(colon + 1)); }
+		} else if (arg == "--pages") {
+			pages = next;
+		} else if (arg == "--pool-cap") {
+			poolCap = max(static_cast<u32>(atoi(next)), 1u);
+		} else if (arg == "--loss") {
+			impairOpts.lossRate = atof(next);
+		} else if (arg == "--burst") {
+			impairOpts.burstEnter = atof(next);  // "enter[:exit]"
+			if (auto colon = strchr(next, ':')) { impairOpts.burstExit = atof(colon + 1); }
+		} else if (arg == "--dup") {
+			impairOpts.duplicateRate = atof(next);
+		} else if (arg == "--reorder") {
+			impairOpts.reorderRate = atof(next);
+		} else if (arg == "--delay") {
+			impairOpts.delay = takeUs();
+		} else if (arg == "--jitter") {
+			impairOpts.jitter = takeUs();
+		} else if (arg == "--seed") {
+			impairOpts.seed = strtoull(next, nullptr, 10);
+		} else {
+			tLogError("Unknown option {}", arg);
+			return false;
+		}
+		i++;
+	}
+
+	argc = kept;
+	return true;
+}
+
+template<typename Policy>
+void applyIncomplete(TBasicReassembly<Policy>& reassembler)
+{
+	reassembler.allowPushIncompleteFrames(incomplete != "drop");
+	reassembler.truncateIncompleteFrames(incomplete == "truncate");
+
+	if (!reassembler.setJitterBuffer(holdFrames, chrono::milliseconds(holdMs))) {
+		tLogWarn("Invalid jitter buffer {} frames / {} ms, left off", holdFrames, holdMs);
+	}
+}
+
+TFramePool::Options poolOptions()
+{
+	TFramePool::Options options;
+	for (auto& slots : options.maxSlots) { slots *= poolCap; }
+	return options;
+}
+
+void applyPages(TVidRender& renderer)
+{
+	using PageMode = TFramePool::PageMode;
+
+	auto mode = pages.substr(0, pages.find(':'));
+	bool lock = pages.ends_with(":lock");
+
+	if (mode == "small" && !lock) { return; }
+
+	auto wanted = mode == "huge"  ? PageMode::EXPLICIT_HUGE
+				  : mode == "thp" ? PageMode::TRANSPARENT_HUGE
+								  : PageMode::SMALL;
+
+	if (!renderer.setFramePoolBacking(wanted, lock)) {
+		tLogWarn("Frame pool backing '{}' not fully applied, see above", pages);
+	}
+}
+
+template<typename Policy>
+void reportImpairment(const TBasicPacketFeeder<Policy>& feeder)
+{
+	if (auto impairment = feeder.getImpairment()) {
+		auto stats = impairment->getStats();
+		tLogInfo(
+			"Impairment: {} submitted, {} lost ({} in bursts), {} duplicated, {} reordered, {} "
+			"delayed, {} overflowed",
+			stats.submitted,
+			stats.lost,
+			stats.burstLost,
+			stats.duplicated,
+			stats.reordered,
+			stats.delayed,
+			stats.overflowed
+		);
+	}
+}
+
+template<typename Policy>
+void reportReassembly(const TBasicReassembly<Policy>& reassembler)
+{
+	auto stats = reassembler.getStats();
+	tLogInfo(
+		"Reassembly: {} completed, {} pushed incomplete, {} timed out, {} evicted ({} large), {} "
+		"duplicate sections, {} stale packets, {} resyncs, {} packets without a frame slot, {} "
+		"without a reassembly slot",
+		stats.completed,
+		stats.pushedIncomplete,
+		stats.timedOut,
+		stats.evicted(),
+		stats.evictedLarge,
+		stats.duplicateSecs,
+		stats.stalePackets,
+		stats.resyncs,
+		stats.poolExhausted,
+		stats.noReAsmSlot
+	);
+
+	for (u32 b = 0; b < TReAsmStats::histBuckets; b++) {
+		if (stats.asmTimeHist[b] == 0) { continue; }
+		tLogInfo(
+			"  assembled in >= {:>7} us: {}",
+			TReAsmStats::bucketFloor(b).count(),
+			stats.asmTimeHist[b]
+		);
+	}
+}
+
+void reportPool(const TVidRender& renderer)
+{
+	auto stats = renderer.getFramePoolStats();
+	tLogInfo(
+		"Frame pool: {} acquired, {} failed, peak {} slots in use, {} grown, {} shrunk, held {} us "
+		"on average",
+		stats.acquired,
+		stats.failures,
+		stats.highWater,
+		stats.grown,
+		stats.shrunk,
+		stats.avgHoldTime.count()
+	);
+
+	for (const auto& sizeClass : stats.classes) {
+		tLogInfo(
+			"  {:>7} B slots: peak {} of {} (cap {})",
+			sizeClass.slotLen,
+			sizeClass.highWater,
+			sizeClass.slots,
+			sizeClass.maxSlots
+		);
+	}
+}
+
+// 生成 frames 个长度为 frameLen 的帧，按 Policy 的 MTU 分片后依次追加
+template<typename Policy>
+void synthesize(TMemPacketSource& source, u32 frames, u32 frameLen)
+{
+	vector<u8> packet(Policy::mtuLen);
+
+	constexpr u32 maxPayload = TBasicReassembly<Policy>::maxPayloadSize;
+
+	u32 secCount = (frameLen + maxPayload - 1) / maxPayload;
+
+	for (u32 f = 0; f < frames; f++) {
+		for (u32 s = 0; s < secCount; s++) {
+			u32 payload = min(maxPayload, frameLen - s * maxPayload);
+
+			TPacketHeader header{ static_cast<u16>(f), static_cast<u16>(s), frameLen };
+			memcpy(packet.data(), &header, sizeof(header));
+			memset(packet.data() + sizeof(header), static_cast<int>(f + s), payload);
+
+			source.append(span(packet).first(sizeof(header) + payload));
+		}
+	}
+}
+
+// 按录制时的节奏（或 speed 倍速）回放抓包文件
+template<typename Policy>
+int replay(const char* path, f64 speed)
+{
+	auto capture = TCapturePacketSource::create(path);
+	if (!capture->isOpen()) { return -1; }
+
+	capture->setPacing(TCapturePacketSource::Pacing::RECORDED, speed);
+
+	try {
+		auto renderer = TVidRender::create(262'144, {}, poolOptions());
+		applyPages(*renderer);
+
+		auto reassembler = TBasicReassembly<Policy>::create(renderer);
+		auto feeder      = TBasicPacketFeeder<Policy>::createUni(reassembler);
+		feeder->setImpairment(impairOpts);
+		applyIncomplete(*reassembler);
+
+		auto stats = feeder->feed(*capture);
+
+		tLogInfo(
+			"Replayed {} datagrams in {:.3f} s at {}x, last pushed frame {}",
+			stats.packets,
+			static_cast<f64>(stats.elapsed.count()) / 1e9,
+			speed,
+			reassembler->getLastPushedIdx()
+		);
+		reportImpairment(*feeder);
+		reportReassembly(*reassembler);
+		reportPool(*renderer);
+	} catch (const exception& ex) {
+		tLogError("Error happend: {}", ex.what());
+		return -1;
+	}
+
+	return 0;
+}
+
+template<typename Policy>
+int run(int argc, char* argv[])
+{
+	if (argc > 2 && strcmp(argv[1], "--replay") == 0) {
+		return replay<Policy>(argv[2], argc > 3 ? atof(argv[3]) : 1.0);
+	}
+
+	auto memSource = TMemPacketSource::create();
+	u64  loops     = 1;
+
+	if (argc > 2 && strcmp(argv[1], "--capture") == 0) {
+		auto capture = TCapturePacketSource::create(argv[2]);
+		if (!capture->isOpen()) { return -1; }
+
+		memSource->appendFrom(*capture);
+		if (argc > 3) { loops = strtoull(argv[3], nullptr, 10); }
+	} else if (argc > 3 && strcmp(argv[1], "--udp") == 0) {
+		auto udp = TUdpPacketSource::create(
+			static_cast<u16>(atoi(argv[2])), "127.0.0.1", 32, true, Policy::mtuLen
+		);
+		if (!udp->isBound()) { return -1; }
+
+		tLogInfo("Collecting {} datagrams...", argv[3]);
+		memSource->appendFrom(*udp, strtoull(argv[3], nullptr, 10));
+		if (argc > 4) { loops = strtoull(argv[4], nullptr, 10); }
+	} else {
+		u32 frames   = argc > 1 ? static_cast<u32>(atoi(argv[1])) : 600;
+		u32 frameLen = argc > 2 ? static_cast<u32>(atoi(argv[2])) : 60'000;
+		if (argc > 3) { loops = strtoull(argv[3], nullptr, 10); }
+
+		synthesize<Policy>(*memSource, frames, frameLen);
+	}
+
+	memSource->setLoops(loops);
+
+	tLogInfo(
+		"{} datagrams ({} bytes) in memory, replaying {} times",
+		memSource->size(),
+		memSource->bytes(),
+		loops
+	);
+
+	try {
+		auto renderer = TVidRender::create(262'144, {}, poolOptions());
+		applyPages(*renderer);
+
+		auto reassembler = TBasicReassembly<Policy>::create(renderer);
+		auto feeder      = TBasicPacketFeeder<Policy>::createUni(reassembler);
+		feeder->setImpairment(impairOpts);
+		applyIncomplete(*reassembler);
+
+		auto stats = feeder->feed(*memSource);
+
+		tLogInfo(
+			"Fed {} datagrams in {:.3f} s: {:.0f} datagrams/s, {:.1f} Mbit/s, last pushed frame {}",
+			stats.packets,
+			static_cast<f64>(stats.elapsed.count()) / 1e9,
+			stats.packetsPerSec(),
+			stats.megabitsPerSec(),
+			reassembler->getLastPushedIdx()
+		);
+		reportImpairment(*feeder);
+		reportReassembly(*reassembler);
+		reportPool(*renderer);
+	} catch (const exception& ex) {
+		tLogError("Error happend: {}", ex.what());
+		return -1;
+	}
+
+	return 0;
+}
+
+// Usage: reasm-bench [frames] [frame length] [loops]
+//        reasm-bench --capture <file> [loops]
+//        reasm-bench --replay <file> [speed]
+//        reasm-bench --udp <port> <datagrams to collect> [loops]
+// With any of the above: [--policy <default | small-mtu | jumbo>]
+//        [--incomplete <drop | whole | truncate>] (timed out frames)
+//        [--hold <frames>[:<ms>]] (jitter buffer, in-order delivery)
+//        [--pages <small | thp | huge>[:lock]] (frame pool page size, mlock)
+//        [--pool-cap <times>] (let the frame pool grow up to that many times its size)
+// Impairment, with any of the above: [--loss <rate>] [--burst <enter>[:<exit>]] [--dup <rate>]
+//        [--reorder <rate>] [--delay <us>] [--jitter <us>] [--seed <seed>]
+int main(int argc, char* argv[])
+{
+	TVidRender::initContext(&argc, &argv);
+
+	if (!parseOptions(argc, argv)) { return -1; }
+
+	if (policyName == "default") { return run<TDefaultReAsmPolicy>(argc, argv); }
+	if (policyName == "small-mtu") { return run<TSmallMtuReAsmPolicy>(argc, argv); }
+	if (policyName == "jumbo") { return run<TJumboReAsmPolicy>(argc, argv); }
+
+	tLogError("Unknown reassembly policy {}", policyName);
+	return -1;
+}
@@ -1,13 +1,26 @@
 #include "img_trans/net/TReassembly.hpp"
 #include "img_trans/net/TRecv.hpp"
+#include "img_trans/vid_render/TVidRender.hpp"
 #include "utils/TLog.hpp"
 
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <csignal>
+#include <cstdlib>
+#include <cstring>
 #include <exception>
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <thread>
+#include <vector>
 
 #define T_LOG_TAG "[TRecv Test] "
 
@@ -22,15 +35,207 @@ void onSignal(int signal)
 	isRunning.store(false);
 }
 
-int main()
+constexpr u32 scriptFrames = 120;
+
+// Send the same loopback stream through one receive backend, return the reassembly counters.
+// Every frame starts with a duplicated section and is followed by a stale section of the frame
+// before it. Every tenth frame does not fit the 16 KiB slots, the only ones in the frame pool.
+// With `held`, the jitter buffer is on instead: every third frame arrives one frame early and
+// is held, then one of its sections comes again before the frame it waits for.
+optional<TReAsmStats> runScripted(TRecvBackend backend, u16 port, bool held)
+{
+	using Header = TReassembly::Header;
+
+	constexpr u32 maxPayload = TReassembly::maxPayloadSize;
+
+	auto frameLen = [held](u32 f) { return f % 10 == 0 && !held ? 20'000u : 12'000u; };
+
+	TFramePool::Options poolOptions;
+	poolOptions.slots    = { 128, 0, 0, 0 };
+	poolOptions.maxSlots = { 128, 0, 0, 0 };
+
+	auto renderer    = TVidRender::create(262'144, {}, poolOptions);
+	auto reassembler = TReassembly::create(renderer);
+
+	if (held) { reassembler->setJitterBuffer(2, 100ms); }
+
+	TRecvOptions opts;
+	opts.backend = backend;
+
+	auto recv = TRecv::createUni(reassembler, port, "127.0.0.1", opts);
+	if (recv->start() != 0) { return nullopt; }
+
+	int sock = ::socket(AF_INET, SOCK_DGRAM, 0);
+	if (sock < 0) { return nullopt; }
+
+	sockaddr_in dest{};
+	dest.sin_family = AF_INET;
+	dest.sin_port   = htons(port);
+	inet_pton(AF_INET, "127.0.0.1", &dest.sin_addr);
+
+	vector<u8> packet(TReassembly::mtuLen);
+	u64        sent = 0;
+
+	auto send = [&](u32 f, u32 s) {
+		u32    len = frameLen(f);
+		Header header{ static_cast<u16>(f), static_cast<u16>(s), len };
+		u32    payload = min(maxPayload, len - s * maxPayload);
+
+		memcpy(packet.data(), &header, sizeof(Header));
+		memset(packet.data() + sizeof(Header), static_cast<int>(f), payload);
+
+		auto ret = ::sendto(
+			sock,
+			packet.data(),
+			sizeof(Header) + payload,
+			0,
+			reinterpret_cast<const sockaddr*>(&dest),
+			sizeof(dest)
+		);
+		if (ret > 0) { sent++; }
+	};
+
+	auto sendFrame = [&](u32 f) {
+		u32 secCount = (frameLen(f) + maxPayload - 1) / maxPayload;
+		for (u32 s = 0; s < secCount; s++) { send(f, s); }
+	};
+
+	for (u32 f = 1; f <= scriptFrames; f++) {
+		if (held) {
+			if (f % 3 == 1) {
+				sendFrame(f);
+				sendFrame(f + 2);
+				send(f + 2, 0);
+				sendFrame(f + 1);
+			}
+		} else {
+			send(f, 0);
+			sendFrame(f);
+			if (f > 1) { send(f - 1, 0); }
+		}
+
+		this_thread::sleep_for(1ms);  // Keep clear of the socket receive buffer
+	}
+
+	this_thread::sleep_for(200ms);
+	recv->stop();
+	::close(sock);
+
+	auto recvStats = recv->getRecvStats();
+	if (recvStats.datagrams != sent) {
+		tLogError(
+			"Backend {} received {} of {} datagrams",
+			static_cast<int>(backend),
+			recvStats.datagrams,
+			sent
+		);
+		return nullopt;
+	}
+
+	return reassembler->getStats();
+}
+
+// A backend counting a datagram twice, or not at all, disagrees with CLASSIC here. A section
+// of a held frame must count as stale, not open a second copy of the frame that times out.
+int compareBackends()
+{
+	constexpr array<TRecvBackend, 4> backends{
+		TRecvBackend::CLASSIC, TRecvBackend::BATCHED, TRecvBackend::ZERO_COPY,
+		TRecvBackend::IO_URING
+	};
+
+	bool matched = true;
+
+	for (bool held : { false, true }) {
+		optional<TReAsmStats> reference;
+
+		for (u32 i = 0; i < backends.size(); i++) {
+			auto stats = runScripted(backends[i], static_cast<u16>(3334 + i), held);
+			if (!stats) { return -1; }
+
+			tLogInfo(
+				"Backend {}{}: {} completed, {} timed out, {} duplicate sections, {} stale "
+				"packets, {} packets without a frame slot, {} resyncs",
+				static_cast<int>(backends[i]),
+				held ? " (jitter buffer)" : "",
+				stats->completed,
+				stats->timedOut,
+				stats->duplicateSecs,
+				stats->stalePackets,
+				stats->poolExhausted,
+				stats->resyncs
+			);
+
+			if (held && (stats->completed != scriptFrames || stats->timedOut != 0 ||
+						 stats->stalePackets != scriptFrames / 3)) {
+				tLogError(
+					"Backend {} reassembled a held frame twice", static_cast<int>(backends[i])
+				);
+				matched = false;
+			}
+
+			if (!reference) {
+				reference = stats;
+				continue;
+			}
+
+			if (stats->completed != reference->completed ||
+				stats->timedOut != reference->timedOut ||
+				stats->duplicateSecs != reference->duplicateSecs ||
+				stats->stalePackets != reference->stalePackets ||
+				stats->poolExhausted != reference->poolExhausted ||
+				stats->noReAsmSlot != reference->noReAsmSlot ||
+				stats->resyncs != reference->resyncs) {
+				tLogError("Backend {} disagrees with CLASSIC", static_cast<int>(backends[i]));
+				matched = false;
+			}
+		}
+	}
+
+	return matched ? 0 : -1;
+}
+
+// Usage: recv-test [--batched [batch size] | --zero-copy | --io-uring [buffer count]]
+//                  [--capture <file>]
+//        recv-test --compare-backends
+int main(int argc, char* argv[])
 {
+	if (argc > 1 && strcmp(argv[1], "--compare-backends") == 0) {
+		TVidRender::initContext(&argc, &argv);
+
+		try {
+			return compareBackends();
+		} catch (const exception& ex) {
+			tLogError("Error happend: {}", ex.what());
+			return -1;
+		}
+	}
+
+	const char* capturePath = nullptr;
+	for (int i = 1; i + 1 < argc; i++) {
+		if (strcmp(argv[i], "--capture") == 0) { capturePath = argv[i + 1]; }
+	}
+
+	TRecvOptions opts;
+	if (argc > 1 && strcmp(argv[1], "--batched") == 0) {
+		opts.backend = TRecvBackend::BATCHED;
+		if (argc > 2) { opts.batchSize = static_cast<u32>(atoi(argv[2])); }
+	} else if (argc > 1 && strcmp(argv[1], "--zero-copy") == 0) {
+		opts.backend = TRecvBackend::ZERO_COPY;
+	} else if (argc > 1 && strcmp(argv[1], "--io-uring") == 0) {
+		opts.backend = TRecvBackend::IO_URING;
+		if (argc > 2) { opts.uringBufCount = static_cast<u32>(atoi(argv[2])); }
+	}
+
 	try {
 		TReassembly::SharedPtr reassembler = std::make_shared<TReassembly>(nullptr);
-		auto                   recv        = TRecv::createUni(reassembler);
+		auto                   recv = TRecv::createUni(reassembler, 3334, "127.0.0.1", opts);
 
 		signal(SIGINT, onSignal);
 		signal(SIGTERM, onSignal);
 
+		if (capturePath) { recv->startCapture(capturePath); }
+
 		recv->start();
 
 		cout << "TRecv is running. Press Ctrl+C to stop." << endl;
@@ -38,6 +243,20 @@ int main()
 		isRunning.store(true);
 
 		while (isRunning.load()) { this_thread::sleep_for(100ms); }
+
+		recv->stop();
+
+		if (capturePath) { tLogInfo("Captured {} datagrams", recv->stopCapture()); }
+
+		tLogInfo("Active receive backend: {}", static_cast<int>(recv->getActiveBackend()));
+
+		auto stats = recv->getRecvStats();
+		tLogInfo(
+			"Received {} datagrams in {} syscalls, avg batch fill: {:.2f}",
+			stats.datagrams,
+			stats.recvCalls,
+			stats.avgBatchFill()
+		);
 	} catch (const exception& ex) {
 		tLogError("Error happend: {}", ex.what());
 		return -1;
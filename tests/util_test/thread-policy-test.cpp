@@ -0,0 +1,63 @@
+#include "utils/TLog.hpp"
+#include "utils/TThreadPolicy.hpp"
+
+#include <string>
+#include <thread>
+
+#define T_LOG_TAG ""
+
+using namespace gentau;
+
+using namespace std;
+
+void applyAndReport(string_view name, const TThreadPolicy& policy)
+{
+	// 每个策略都在新线程上应用，避免相互影响
+	thread worker([&]() {
+		auto applied = policy.apply(name);
+		tLogInfo("{:<12}: {}", name, applied.toString());
+	});
+	worker.join();
+}
+
+int main(int argc, char* argv[])
+{
+	applyAndReport("inherit", {});
+
+	// 逐个成员赋值构造策略，避免指定初始化器遗漏成员时的 -Wmissing-field-initializers
+	TThreadPolicy niceNeg;
+	niceNeg.sched    = TThreadPolicy::Sched::NICE;
+	niceNeg.priority = -5;
+	applyAndReport("nice", niceNeg);
+
+	// nice 0 是一个有效的请求，用于撤销继承而来的 nice 值
+	TThreadPolicy niceZero;
+	niceZero.sched    = TThreadPolicy::Sched::NICE;
+	niceZero.priority = 0;
+	applyAndReport("nice-zero", niceZero);
+
+	TThreadPolicy fifo;
+	fifo.sched        = TThreadPolicy::Sched::FIFO;
+	fifo.priority     = 50;
+	fifo.fallbackNice = -10;
+	applyAndReport("fifo", fifo);
+
+	TThreadPolicy rrCpu0;
+	rrCpu0.sched    = TThreadPolicy::Sched::RR;
+	rrCpu0.priority = 10;
+	rrCpu0.cpus     = { 0 };
+	applyAndReport("rr-cpu0", rrCpu0);
+
+	// CPU 4095 通常不存在，应该被忽略
+	TThreadPolicy badCpus;
+	badCpus.cpus = { 0, 4095 };
+	applyAndReport("bad-cpus", badCpus);
+
+	if (argc > 1 && string_view(argv[1]) == "--lock") {
+		TThreadPolicy lockMem;
+		lockMem.lockMemory = true;
+		applyAndReport("mlock", lockMem);
+	}
+
+	return 0;
+}
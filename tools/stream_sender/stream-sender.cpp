@@ -0,0 +1,383 @@
+#include "img_trans/net/TReassembly.hpp"
+#include "img_trans/vid_render/TFramePool.hpp"
+#include "utils/TLog.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#define T_LOG_TAG "[Stream Sender] "
+
+using namespace gentau;
+using namespace std;
+
+using Header = TReassembly::Header;
+using Clock  = chrono::steady_clock;
+
+atomic_bool isRunning(true);
+
+void onSignal(int signal)
+{
+	isRunning.store(false);
+}
+
+struct SenderOptions
+{
+	string      file    = "./res/raw_sintel_720p_stream.h265";
+	const char* ip      = "127.0.0.1";
+	u16         port    = 3334;
+	f64         fps     = 60.0;
+	f64         mbps    = 0.0;  // 0: every access unit is sent as one burst
+	u64         loops   = 1;    // 0: loop until interrupted
+	u32         batch   = 32;   // Datagrams per sendmmsg() when not rate limited
+	bool        verbose = false;
+};
+
+/**
+ * 按 Annex-B 起始码切分 NAL 单元，再按 H.265 的接入单元（Access Unit）边界规则聚合：
+ *  - 在已出现 VCL NAL 之后遇到 AUD / VPS / SPS / PPS / 前缀 SEI / 保留类型时开始新的接入单元
+ *  - 在已出现 VCL NAL 之后遇到 first_slice_segment_in_pic_flag 为 1 的 VCL NAL 时开始新的接入单元
+ *
+ * @return 每个接入单元（包含其起始码）在 stream 中的范围
+ */
+vector<span<const u8>> splitAccessUnits(span<const u8> stream)
+{
+	vector<size_t> nalStarts;  // Offset of the start code of each NAL unit
+	for (size_t i = 0; i + 3 <= stream.size(); i++) {
+		if (stream[i] != 0 || stream[i + 1] != 0) { continue; }
+
+		if (stream[i + 2] == 1) {
+			// 00 00 00 01 is the same start code, keep its leading zero with it
+			nalStarts.push_back(i > 0 && stream[i - 1] == 0 ? i - 1 : i);
+			i += 2;
+		}
+	}
+
+	vector<span<const u8>> units;
+	if (nalStarts.empty()) { return units; }
+
+	size_t unitStart = nalStarts.front();
+	bool   seenVcl   = false;
+
+	for (size_t n = 0; n < nalStarts.size(); n++) {
+		size_t begin = nalStarts[n];
+
+		size_t hdr = begin + (stream[begin + 2] == 1 ? 3 : 4);  // First byte of the NAL header
+		if (hdr + 2 >= stream.size()) { break; }
+
+		u8   type          = (stream[hdr] >> 1) & 0x3f;
+		bool isVcl         = type <= 31;
+		bool firstSliceSeg = isVcl && (stream[hdr + 2] & 0x80) != 0;
+		bool opensUnit     = (type >= 32 && type <= 35) || type == 39 ||  // VPS SPS PPS AUD SEI
+						 (type >= 41 && type <= 44) || (type >= 48 && type <= 55);
+
+		if (seenVcl && (opensUnit || firstSliceSeg)) {
+			units.push_back(stream.subspan(unitStart, begin - unitStart));
+			unitStart = begin;
+			seenVcl   = false;
+		}
+
+		if (isVcl) { seenVcl = true; }
+	}
+
+	units.push_back(stream.subspan(unitStart));
+	return units;
+}
+
+struct SendStats
+{
+	u64 frames    = 0;
+	u64 datagrams = 0;
+	u64 bytes     = 0;
+	u64 failed    = 0;  // Datagrams the kernel refused (ENOBUFS, ...)
+	u64 late      = 0;  // Access units that could not start on their schedule
+};
+
+class StreamSender
+{
+  private:
+	const SenderOptions& opts;
+	int                  sock = -1;
+	sockaddr_in          dest{};
+
+	vector<Header>  headers;
+	vector<iovec>   iovs;  // Two per datagram: protocol header, then the payload
+	vector<mmsghdr> msgs;
+
+	Clock::time_point nextByteSlot{};  // Bitrate pacing, when the next datagram may leave
+
+  public:
+	SendStats stats;
+
+  private:
+	// 把一个接入单元按 MTU_LEN 拆分成分片，头部与负载通过 iovec 聚合发送，不做拷贝
+	void packetize(span<const u8> unit, u16 frameIdx)
+	{
+		constexpr u32 maxPayload = TReassembly::maxPayloadSize;
+
+		auto frameLen = static_cast<u32>(unit.size());
+		u32  secCount = (frameLen + maxPayload - 1) / maxPayload;
+
+		headers.resize(secCount);
+		iovs.resize(secCount * 2);
+		msgs.resize(secCount);
+
+		for (u32 s = 0; s < secCount; s++) {
+			auto payload = unit.subspan(s * maxPayload, min(maxPayload, frameLen - s * maxPayload));
+
+			headers[s] = Header{ frameIdx, static_cast<u16>(s), frameLen };
+
+			iovs[s * 2]     = { &headers[s], sizeof(Header) };
+			iovs[s * 2 + 1] = { const_cast<u8*>(payload.data()), payload.size() };
+
+			msgs[s]                     = {};
+			msgs[s].msg_hdr.msg_name    = &dest;
+			msgs[s].msg_hdr.msg_namelen = sizeof(dest);
+			msgs[s].msg_hdr.msg_iov     = &iovs[s * 2];
+			msgs[s].msg_hdr.msg_iovlen  = 2;
+		}
+	}
+
+	void account(u32 first, i32 sent)
+	{
+		for (i32 i = 0; i < sent; i++) {
+			stats.bytes += sizeof(Header) + msgs[first + i].msg_hdr.msg_iov[1].iov_len;
+		}
+		stats.datagrams += static_cast<u64>(sent);
+	}
+
+	void sendBurst()
+	{
+		for (u32 i = 0; i < msgs.size();) {
+			auto count = min<u32>(opts.batch, static_cast<u32>(msgs.size()) - i);
+			auto sent  = ::sendmmsg(sock, msgs.data() + i, count, 0);
+
+			if (sent < 0) {
+				stats.failed++;  // Skip the datagram the kernel refused, keep the rest going
+				i++;
+				continue;
+			}
+
+			account(i, sent);
+			i += static_cast<u32>(sent);
+		}
+	}
+
+	void sendPaced()
+	{
+		const f64 nsPerByte = 8e3 / opts.mbps;
+
+		for (u32 i = 0; i < msgs.size(); i++) {
+			auto now = Clock::now();
+			if (nextByteSlot > now) { this_thread::sleep_until(nextByteSlot); }
+			nextByteSlot = max(nextByteSlot, now);
+
+			if (::sendmsg(sock, &msgs[i].msg_hdr, 0) < 0) {
+				stats.failed++;
+				continue;
+			}
+
+			account(i, 1);
+
+			auto len      = static_cast<f64>(sizeof(Header) + msgs[i].msg_hdr.msg_iov[1].iov_len);
+			nextByteSlot += chrono::nanoseconds(static_cast<i64>(len * nsPerByte));
+		}
+	}
+
+  public:
+	bool open()
+	{
+		sock = ::socket(AF_INET, SOCK_DGRAM, 0);
+		if (sock < 0) {
+			tLogError(
+				"Failed to create socket: {}", error_code(errno, system_category()).message()
+			);
+			return false;
+		}
+
+		int sendBuf = 4 * 1024 * 1024;
+		::setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &sendBuf, sizeof(sendBuf));
+
+		dest.sin_family = AF_INET;
+		dest.sin_port   = htons(opts.port);
+		if (inet_pton(AF_INET, opts.ip, &dest.sin_addr) <= 0) {
+			tLogError("Invalid IP address: {}", opts.ip);
+			return false;
+		}
+
+		return true;
+	}
+
+	void run(const vector<span<const u8>>& units)
+	{
+		const auto period =
+			chrono::duration_cast<Clock::duration>(chrono::duration<f64>(1.0 / opts.fps));
+
+		u16  frameIdx = 0;
+		auto due      = Clock::now();
+
+		for (u64 loop = 0; isRunning.load() && (opts.loops == 0 || loop < opts.loops); loop++) {
+			for (const auto& unit : units) {
+				if (!isRunning.load()) { break; }
+
+				auto now = Clock::now();
+				if (now < due) {
+					this_thread::sleep_until(due);
+				} else if (now - due > period) {
+					stats.late++;
+					due = now;  // Do not burst to catch up, that is not what a real link does
+				}
+
+				packetize(unit, frameIdx++);
+
+				if (opts.mbps > 0.0) {
+					sendPaced();
+				} else {
+					sendBurst();
+				}
+
+				stats.frames++;
+				due += period;
+
+				if (opts.verbose) {
+					tLogDebug(
+						"Frame {} sent, {} bytes in {} sections",
+						static_cast<u16>(frameIdx - 1),
+						unit.size(),
+						msgs.size()
+					);
+				}
+			}
+		}
+	}
+
+  public:
+	explicit StreamSender(const SenderOptions& _opts) : opts(_opts) {}
+	~StreamSender()
+	{
+		if (sock > -1) { ::close(sock); }
+	}
+};
+
+// Usage: stream-sender [--file <h265 file>] [--ip <ip>] [--port <port>] [--fps <fps>]
+//                      [--mbps <bitrate, 0 for bursts>] [--loops <count, 0 for endless>]
+//                      [--batch <datagrams per sendmmsg>] [--verbose]
+int main(int argc, char* argv[])
+{
+	SenderOptions opts;
+
+	for (int i = 1; i < argc; i++) {
+		string_view arg  = argv[i];
+		const char* next = i + 1 < argc ? argv[i + 1] : nullptr;
+
+		if (arg == "--verbose") {
+			opts.verbose = true;
+		} else if (!next) {
+			tLogError("Missing value for {}", arg);
+			return -1;
+		} else if (arg == "--file") {
+			opts.file = next, i++;
+		} else if (arg == "--ip") {
+			opts.ip = next, i++;
+		} else if (arg == "--port") {
+			opts.port = static_cast<u16>(atoi(next)), i++;
+		} else if (arg == "--fps") {
+			opts.fps = atof(next), i++;
+		} else if (arg == "--mbps") {
+			opts.mbps = atof(next), i++;
+		} else if (arg == "--loops") {
+			opts.loops = strtoull(next, nullptr, 10), i++;
+		} else if (arg == "--batch") {
+			opts.batch = static_cast<u32>(max(1, atoi(next))), i++;
+		} else {
+			tLogError("Unknown option {}", arg);
+			return -1;
+		}
+	}
+
+	if (opts.fps <= 0.0) {
+		tLogError("Frame rate must be positive");
+		return -1;
+	}
+
+	ifstream file(opts.file, ios::binary);
+	if (!file.is_open()) {
+		tLogError("Failed to open {}", opts.file);
+		return -1;
+	}
+	vector<u8> stream((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+
+	auto units = splitAccessUnits(stream);
+	if (units.empty()) {
+		tLogError("No H.265 access unit found in {}", opts.file);
+		return -1;
+	}
+
+	size_t maxUnit = 0;
+	for (const auto& unit : units) { maxUnit = max(maxUnit, unit.size()); }
+
+	tLogInfo(
+		"{} access units from {} ({} bytes), largest {} bytes",
+		units.size(),
+		opts.file,
+		stream.size(),
+		maxUnit
+	);
+
+	if (maxUnit > TFramePool::slotLen) {
+		tLogWarn(
+			"Access units over {} bytes exceed the frame slot and will be dropped by the receiver",
+			TFramePool::slotLen
+		);
+	}
+
+	StreamSender sender(opts);
+	if (!sender.open()) { return -1; }
+
+	signal(SIGINT, onSignal);
+	signal(SIGTERM, onSignal);
+
+	tLogInfo(
+		"Sending to {}:{} at {} fps, {}",
+		opts.ip,
+		opts.port,
+		opts.fps,
+		opts.mbps > 0.0 ? to_string(opts.mbps) + " Mbit/s" : "unlimited bitrate"
+	);
+
+	auto start = Clock::now();
+	sender.run(units);
+	auto secs = chrono::duration<f64>(Clock::now() - start).count();
+
+	const auto& stats = sender.stats;
+	tLogInfo(
+		"Sent {} frames, {} datagrams, {} bytes in {:.2f} s ({:.1f} fps, {:.2f} Mbit/s), {} "
+		"datagrams refused, {} frames late",
+		stats.frames,
+		stats.datagrams,
+		stats.bytes,
+		secs,
+		secs > 0 ? static_cast<f64>(stats.frames) / secs : 0.0,
+		secs > 0 ? static_cast<f64>(stats.bytes) * 8 / secs / 1e6 : 0.0,
+		stats.failed,
+		stats.late
+	);
+
+	return 0;
+}